@@ -0,0 +1,178 @@
+/*
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/*
+ * Host-side benchmark of the FifoDataport. It is not part of the library, see
+ * LIB_IO_BUILD_BENCHMARK in CMakeLists.txt. The results only make sense
+ * relative to each other on the same machine.
+ */
+
+#include "lib_io/FifoDataport.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define INDEX_ROUNDS        (1u << 22)
+#define INDEX_CHUNK         16
+
+#define STREAM_CAPACITY     (1u << 20)
+#define STREAM_BLOCK        (64u << 10)
+#define STREAM_TOTAL        (256ull << 20)
+
+
+//------------------------------------------------------------------------------
+static uint64_t
+getNanoseconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000u) + (uint64_t)ts.tv_nsec;
+}
+
+
+//------------------------------------------------------------------------------
+// Allocates and constructs a FifoDataport, returns NULL if the capacity is not
+// possible in this configuration.
+static FifoDataport*
+createPort(
+    size_t capacity)
+{
+    size_t size = (sizeof(FifoDataport) + capacity
+                   + FifoDataport_CACHE_LINE_SIZE - 1)
+                  & ~((size_t)FifoDataport_CACHE_LINE_SIZE - 1);
+    FifoDataport* port = aligned_alloc(FifoDataport_CACHE_LINE_SIZE, size);
+
+    if ((NULL != port) && !FifoDataport_ctor(port, capacity))
+    {
+        free(port);
+        port = NULL;
+    }
+    return port;
+}
+
+
+//------------------------------------------------------------------------------
+// Small writes and reads in turn, so the time is dominated by the index
+// calculations. A power-of-two capacity uses the mask, the other one the
+// modulo.
+static void
+benchIndexing(void)
+{
+    static const size_t capacities[] = { 4096, 4000 };
+
+    for (size_t i = 0; i < sizeof(capacities) / sizeof(capacities[0]); i++)
+    {
+        FifoDataport* port = createPort(capacities[i]);
+        if (NULL == port)
+        {
+            printf("index capacity %4zu: not supported\n", capacities[i]);
+            continue;
+        }
+
+        char chunk[INDEX_CHUNK] = { 0 };
+        uint64_t start = getNanoseconds();
+        for (size_t round = 0; round < INDEX_ROUNDS; round++)
+        {
+            FifoDataport_write(port, chunk, sizeof(chunk));
+            FifoDataport_read(port, chunk, sizeof(chunk));
+        }
+        uint64_t elapsed = getNanoseconds() - start;
+
+        printf("index capacity %4zu (%s): %6.2f ns per write and read\n",
+               capacities[i],
+               (0 != port->config.mask) ? "mask" : "modulo",
+               (double)elapsed / INDEX_ROUNDS);
+        free(port);
+    }
+}
+
+
+//------------------------------------------------------------------------------
+// Consumer thread of benchStreaming(), it reads until STREAM_TOTAL bytes have
+// arrived.
+static void*
+streamConsumer(
+    void* arg)
+{
+    FifoDataport* port = arg;
+    static char block[STREAM_BLOCK];
+
+    for (uint64_t received = 0; received < STREAM_TOTAL; )
+    {
+        size_t read = FifoDataport_read(port, block, sizeof(block));
+        if (0 == read)
+        {
+            sched_yield();
+        }
+        received += read;
+    }
+    return NULL;
+}
+
+
+//------------------------------------------------------------------------------
+// Large writes with a consumer in another thread, once with regular copies and
+// once with non-temporal copies, see FifoDataport_setStreamingThreshold().
+static void
+benchStreaming(void)
+{
+    static const size_t thresholds[] = { 0, 4096 };
+
+    for (size_t i = 0; i < sizeof(thresholds) / sizeof(thresholds[0]); i++)
+    {
+        FifoDataport* port = createPort(STREAM_CAPACITY);
+        if (NULL == port)
+        {
+            printf("stream: no port\n");
+            return;
+        }
+        FifoDataport_setStreamingThreshold(port, thresholds[i]);
+
+        static char block[STREAM_BLOCK];
+        pthread_t consumer;
+        uint64_t start = getNanoseconds();
+        if (0 != pthread_create(&consumer, NULL, streamConsumer, port))
+        {
+            printf("stream: no thread\n");
+            free(port);
+            return;
+        }
+
+        for (uint64_t sent = 0; sent < STREAM_TOTAL; )
+        {
+            size_t written = FifoDataport_write(port, block, sizeof(block));
+            if (0 == written)
+            {
+                sched_yield();
+            }
+            sent += written;
+        }
+        pthread_join(consumer, NULL);
+        uint64_t elapsed = getNanoseconds() - start;
+
+        printf("stream threshold %4zu (%s): %8.1f MiB/s\n",
+               thresholds[i],
+               (0 != thresholds[i]) ? "streaming" : "memcpy",
+               ((double)STREAM_TOTAL / (1u << 20)) / ((double)elapsed / 1e9));
+        free(port);
+    }
+}
+
+
+//------------------------------------------------------------------------------
+int
+main(void)
+{
+    benchIndexing();
+    benchStreaming();
+    return EXIT_SUCCESS;
+}
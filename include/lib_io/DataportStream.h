@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/**
+ * @addtogroup lib_io
+ * @{
+ *
+ * @file DataportStream.h
+ *
+ * @brief a class that implements the Stream.h interface on top of a pair of
+ *  FifoDataports shared with another component, one for reading and one for
+ *  writing. The data is copied in blocks directly between the caller's buffers
+ *  and the dataports.
+ *
+ * Optional notifiers make the blocking functions Stream_get() and
+ *  Stream_flush() sleep instead of spinning. This side waits on its notifier,
+ *  which the peer signals with the doorbell functions of FifoDataportNotifier.h
+ *  when it writes to our read FifoDataport or reads from our write
+ *  FifoDataport. This side does the same with the peer's notifier.
+ */
+#if !defined(DATAPORT_STREAM_H)
+#define DATAPORT_STREAM_H
+
+
+/* Includes ------------------------------------------------------------------*/
+
+#include "lib_io/FifoDataport.h"
+#include "lib_io/FifoDataportNotifier.h"
+#include "lib_io/Stream.h"
+
+
+/* Exported macro ------------------------------------------------------------*/
+
+#define DataportStream_TO_STREAM(self) (&(self)->parent)
+
+
+/* Exported types ------------------------------------------------------------*/
+
+typedef struct DataportStream DataportStream;
+
+struct DataportStream
+{
+    Stream                  parent;
+    FifoDataport*           readPort;
+    FifoDataport*           writePort;
+    FifoDataportNotifier*   notifier;
+    FifoDataportNotifier*   peerNotifier;
+};
+
+
+/* Exported constants --------------------------------------------------------*/
+/* Exported functions ------------------------------------------------------- */
+/**
+ * @brief constructor. The FifoDataports must have been constructed already by
+ *  their producers.
+ *
+ * @param self pointer to self
+ * @param readPort FifoDataport this side consumes from, can be NULL for an
+ *  output only stream
+ * @param writePort FifoDataport this side produces to, can be NULL for an
+ *  input only stream
+ * @param notifier notifier this side waits on, can be NULL to spin in the
+ *  blocking functions
+ * @param peerNotifier notifier the peer waits on, can be NULL if the peer does
+ *  not wait. It can be the same as 'notifier' if this has separate events for
+ *  waiting and signalling, like a FifoDataportEventNotifier
+ *
+ * @return true if success
+ *
+ */
+bool
+DataportStream_ctor(DataportStream* self,
+                    FifoDataport* readPort,
+                    FifoDataport* writePort,
+                    FifoDataportNotifier* notifier,
+                    FifoDataportNotifier* peerNotifier);
+/**
+ * @brief static implementation of virtual method Stream_write(). The write is
+ *  a non blocking function, it takes at the most the free space of the write
+ *  FifoDataport.
+ *
+ */
+size_t
+DataportStream_write(Stream* self, char const* buffer, size_t length);
+/**
+ * @brief static implementation of virtual method Stream_read()
+ *
+ */
+size_t
+DataportStream_read(Stream* self, char* buffer, size_t length);
+/**
+ * @brief static implementation of virtual method Stream_get(). Without a
+ *  notifier it does not block and returns when the read FifoDataport is empty.
+ *  Timeouts are not supported. An empty delims string is the same as NULL and,
+ *  unlike in InputFifoStream_get(), a NUL byte is never a delimiter.
+ *
+ */
+size_t
+DataportStream_get(Stream* self,
+                   char* buff,
+                   size_t len,
+                   const char* delims,
+                   unsigned timeoutTicks);
+/**
+ * @brief static implementation of virtual method Stream_available()
+ *
+ */
+size_t
+DataportStream_available(Stream* self);
+/**
+ * @brief static implementation of virtual method Stream_flush(). It blocks
+ *  until the peer has read all data from the write FifoDataport.
+ *
+ */
+void
+DataportStream_flush(Stream* self);
+/**
+ * @brief static implementation of virtual method Stream_skip()
+ *
+ */
+void
+DataportStream_skip(Stream* self);
+/**
+ * @brief static implementation of virtual method Stream_dtor()
+ *
+ */
+void
+DataportStream_dtor(Stream* self);
+
+#endif /* DATAPORT_STREAM_H */
+///@}
@@ -17,34 +17,358 @@
  * The dataport buffer containing a FifoDataport is therefore organised in the
  * following way:
  *  __________________________________________________________________________
- * | ------------|------------------------------------------------------------|
- * || dataStruct |                       data                                ||
- * | ------------|------------------------------------------------------------|
+ * | ----------|----------|--------|------------------------------------------|
+ * || producer | consumer | config |                 data                    ||
+ * | ----------|----------|--------|------------------------------------------|
  * |__________________________________________________________________________|
  *
+ * The fields written by the producer ("in", "last") and the fields written by
+ * the consumer ("out", "first") are placed on separate cache lines, so an
+ * update of one side does not invalidate the cache line the other side is
+ * working on (false sharing). Each side also keeps a private copy of the
+ * peer's index on its own cache line. FifoDataport_read(), _write(), _add()
+ * and _remove() read the peer's cache line only when this copy can't serve the
+ * request, so under steady load they touch no remote cache line except for
+ * publishing their own index. The snapshot functions such as
+ * FifoDataport_getContiguous() always read the peer's index, since their
+ * callers poll them for new data or space. The configuration is written by
+ * the constructor only and then stays in the caches of both sides. The size of
+ * a cache line can be adapted by defining FifoDataport_CACHE_LINE_SIZE, both
+ * components sharing a dataport must use the same value.
+ *
  * @note The FifoDataport is supposed to be created by the Producer.
  *
+ * Memory model: producer and consumer may run on different cores, so the
+ * indices are accessed atomically. The producer writes the payload and then
+ * publishes it by storing "in" with release semantics. The consumer loads "in"
+ * with acquire semantics before it accesses the payload, so the payload is
+ * guaranteed to be visible once the new "in" is. The same holds for the
+ * opposite direction: the consumer stores "out" with release semantics when
+ * it is done with the data and the producer loads "out" with acquire semantics
+ * before it reuses the freed space. Each side reads the index it owns without
+ * any ordering, since it is the only writer. No further barriers are needed
+ * around the calls.
+ *
  */
 #pragma once
 
-#include "lib_utils/CharFifo.h"
+#include "lib_debug/Debug.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Defining this adds a statistics block to each FifoDataport, see
+// FifoDataport_getStatistics(). It changes the layout of the dataport, so all
+// components sharing a dataport must use the same setting.
+// #define FIFO_DATAPORT_STATISTICS
+
+// Number of bins of the occupancy histogram, each bin covers an equal part of
+// the capacity.
+#if !defined(FifoDataport_STATS_HISTOGRAM_BINS)
+#define FifoDataport_STATS_HISTOGRAM_BINS   8
+#endif
+
+// Defining this adds latency instrumentation to each FifoDataport: the
+// producer stamps each chunk it adds with a monotonic time, the consumer takes
+// the stamp when the chunk has been removed and counts the delay in a
+// histogram, see FifoDataport_getLatency(). It changes the layout of the
+// dataport, so all components sharing a dataport must use the same setting.
+// #define FIFO_DATAPORT_LATENCY
+
+// Number of chunks that can be stamped at the same time. Chunks added while
+// all stamps are in use are not measured.
+#if !defined(FifoDataport_LATENCY_STAMPS)
+#define FifoDataport_LATENCY_STAMPS     64
+#endif
+
+// The latency histogram is log-linear: each power of two is split into
+// 2^FifoDataport_LATENCY_SUB_BITS bins of equal width.
+#if !defined(FifoDataport_LATENCY_SUB_BITS)
+#define FifoDataport_LATENCY_SUB_BITS   2
+#endif
+
+#define FifoDataport_LATENCY_BINS \
+    ((64 - FifoDataport_LATENCY_SUB_BITS + 1) << FifoDataport_LATENCY_SUB_BITS)
+
+#ifdef FIFO_DATAPORT_LATENCY
+
+// Returns the current time as uint64_t. It must be monotonic and the same
+// clock for producer and consumer, the histogram has the unit of this clock.
+#if !defined(FifoDataport_LATENCY_NOW)
+#if defined(__linux__)
 
-// #define FIFO_DATAPORT_PROFILING
+#include <time.h>
+
+static inline uint64_t
+FifoDataport_latencyNow(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000u) + (uint64_t)ts.tv_nsec;
+}
+
+#define FifoDataport_LATENCY_NOW()  FifoDataport_latencyNow()
+
+#else
+#error "FIFO_DATAPORT_LATENCY requires FifoDataport_LATENCY_NOW() to be defined"
+#endif
+#endif
+
+#endif
+
+// If the capacity of a FIFO is a power of two, buffer indices are calculated
+// by masking instead of a modulo operation. Defining this accepts only such
+// capacities and removes the modulo fallback completely.
+// #define FIFO_DATAPORT_POW2_CAPACITY
+
+// Atomic access to the fields shared between producer and consumer. The
+// fields are plain size_t members that are shared with another address space,
+// so the compiler builtins that also back <stdatomic.h> are used on them
+// directly.
+#define FifoDataport_LOAD_RELAXED(_ptr_) \
+    __atomic_load_n(_ptr_, __ATOMIC_RELAXED)
+
+#define FifoDataport_LOAD_ACQUIRE(_ptr_) \
+    __atomic_load_n(_ptr_, __ATOMIC_ACQUIRE)
+
+#define FifoDataport_STORE_RELEASE(_ptr_, _val_) \
+    __atomic_store_n(_ptr_, _val_, __ATOMIC_RELEASE)
+
+// Hint for the CPU that we are busy waiting on a shared variable.
+#if defined(__i386__) || defined(__x86_64__)
+#define FifoDataport_CPU_RELAX()    __builtin_ia32_pause()
+#elif defined(__aarch64__) || defined(__arm__)
+#define FifoDataport_CPU_RELAX()    __asm__ __volatile__("yield" ::: "memory")
+#else
+#define FifoDataport_CPU_RELAX()    __asm__ __volatile__("" ::: "memory")
+#endif
+
+#if !defined(FifoDataport_CACHE_LINE_SIZE)
+#define FifoDataport_CACHE_LINE_SIZE    64
+#endif
 
 typedef struct
 {
-    CharFifo dataStruct;
-    char     data[];
+    // written by the producer only
+    struct
+    {
+        size_t in;      // total amount of bytes ever added
+        size_t last;    // buffer index where the next byte will be added
+        size_t outSeen; // last value of "out" loaded by the producer
+        size_t reserved;// "in" plus space reserved by multiple producers
+        size_t lost;    // bytes dropped by lossy writes, taken by the consumer
+        size_t sleeping;// producer is about to block, cleared by the waker
+        size_t streamThreshold; // copies from this size on bypass the cache
+    }
+    producer __attribute__((aligned(FifoDataport_CACHE_LINE_SIZE)));
+
+    // written by the consumer only
+    struct
+    {
+        size_t out;     // total amount of bytes ever removed
+        size_t first;   // buffer index of the next byte to be removed
+        size_t inSeen;  // last value of "in" loaded by the consumer
+        size_t sleeping;// consumer is about to block, cleared by the waker
+    }
+    consumer __attribute__((aligned(FifoDataport_CACHE_LINE_SIZE)));
+
+    // written by the constructor only
+    struct
+    {
+        size_t capacity;
+        size_t mask;    // capacity - 1 for a power of two capacity, else 0
+        bool mirrored;  // data area is mapped a second time right after it
+        size_t lowWater;// free space that makes the consumer wake the producer
+    }
+    config __attribute__((aligned(FifoDataport_CACHE_LINE_SIZE)));
+
+#ifdef FIFO_DATAPORT_STATISTICS
+
+    // written by the producer only
+    struct
+    {
+        size_t bytesIn;
+        size_t fullHits;
+        size_t highWater;
+        size_t concurrentChanges;
+        size_t histogram[FifoDataport_STATS_HISTOGRAM_BINS];
+    }
+    producerStats __attribute__((aligned(FifoDataport_CACHE_LINE_SIZE)));
+
+    // written by the consumer only
+    struct
+    {
+        size_t bytesOut;
+        size_t emptyHits;
+        size_t concurrentChanges;
+    }
+    consumerStats __attribute__((aligned(FifoDataport_CACHE_LINE_SIZE)));
+
+#endif
+
+#ifdef FIFO_DATAPORT_LATENCY
+
+    // written by the producer only
+    struct
+    {
+        size_t in;      // total amount of stamps ever written
+        size_t dropped; // chunks not stamped because all stamps were in use
+        struct
+        {
+            size_t   pos;   // value of "in" after adding the chunk
+            uint64_t time;
+        }
+        stamps[FifoDataport_LATENCY_STAMPS];
+    }
+    latencyProducer __attribute__((aligned(FifoDataport_CACHE_LINE_SIZE)));
+
+    // written by the consumer only
+    struct
+    {
+        size_t   out;   // total amount of stamps ever taken
+        uint64_t max;
+        size_t   histogram[FifoDataport_LATENCY_BINS];
+    }
+    latencyConsumer __attribute__((aligned(FifoDataport_CACHE_LINE_SIZE)));
+
+#endif
+
+    char data[] __attribute__((aligned(FifoDataport_CACHE_LINE_SIZE)));
 }
 FifoDataport;
 
+// A block of memory in the FIFO buffer, see FifoDataport_getSegments().
+typedef struct
+{
+    void*  buffer;
+    size_t len;
+}
+FifoDataport_Segment;
+
+// A snapshot of the statistics, see FifoDataport_getStatistics().
+typedef struct
+{
+    size_t bytesIn;             // total amount of bytes added
+    size_t bytesOut;            // total amount of bytes removed
+    size_t fullHits;            // producer found no free space
+    size_t emptyHits;           // consumer found no data
+    size_t highWater;           // maximum amount of bytes in the FIFO
+    size_t concurrentChanges;   // index changes seen while accessing the FIFO
+    size_t histogram[FifoDataport_STATS_HISTOGRAM_BINS]; // occupancy on add
+}
+FifoDataport_Statistics;
+
+// A snapshot of the latency histogram, see FifoDataport_getLatency().
+typedef struct
+{
+    size_t   histogram[FifoDataport_LATENCY_BINS]; // see getLatencyBinValue()
+    uint64_t max;       // maximum latency seen
+    size_t   dropped;   // chunks that have not been measured
+}
+FifoDataport_Latency;
+
+// Each counter has a single writer, so a relaxed load and store is enough to
+// update it. The reader of a snapshot gets consistent single values, but not
+// necessarily a consistent set of values.
+#define FifoDataport_COUNTER_ADD(_field_, _val_) \
+    __atomic_store_n(&(_field_), \
+                     __atomic_load_n(&(_field_), __ATOMIC_RELAXED) + (_val_), \
+                     __ATOMIC_RELAXED)
+
+#ifdef FIFO_DATAPORT_STATISTICS
+
+#define FifoDataport_STATS_ADD(_field_, _val_) \
+    FifoDataport_COUNTER_ADD(_field_, _val_)
+
+#else
+
+#define FifoDataport_STATS_ADD(_field_, _val_)  do {} while (0)
+
+#endif
+
+
+//------------------------------------------------------------------------------
+// Common part of the constructors.
+static inline bool
+FifoDataport_init(
+    FifoDataport* self,
+    size_t capacity,
+    bool mirrored)
+{
+    if ((NULL == self) || (0 == capacity))
+    {
+        return false;
+    }
+
+    bool isPow2 = (0 == (capacity & (capacity - 1)));
+
+#ifdef FIFO_DATAPORT_POW2_CAPACITY
+
+    if (!isPow2)
+    {
+        Debug_LOG_ERROR("FifoDataport capacity %zu is not a power of two",
+                        capacity);
+        return false;
+    }
+
+#endif
+
+    self->config.capacity = capacity;
+    self->config.mask = isPow2 ? capacity - 1 : 0;
+    self->config.mirrored = mirrored;
+    self->config.lowWater = 1;
+
+    self->consumer.out = 0;
+    self->consumer.first = 0;
+    self->consumer.inSeen = 0;
+    self->consumer.sleeping = 0;
+
+    self->producer.last = 0;
+    self->producer.outSeen = 0;
+    self->producer.reserved = 0;
+    self->producer.lost = 0;
+    self->producer.sleeping = 0;
+    self->producer.streamThreshold = 0;
+
+#ifdef FIFO_DATAPORT_STATISTICS
+
+    memset(&self->producerStats, 0, sizeof(self->producerStats));
+    memset(&self->consumerStats, 0, sizeof(self->consumerStats));
+
+#endif
+
+#ifdef FIFO_DATAPORT_LATENCY
+
+    memset(&self->latencyProducer, 0, sizeof(self->latencyProducer));
+    memset(&self->latencyConsumer, 0, sizeof(self->latencyConsumer));
+
+#endif
+
+    // Storing "in" last with release semantics makes the whole header visible
+    // to a consumer that already looks at the dataport.
+    FifoDataport_STORE_RELEASE(&self->producer.in, 0);
+
+    return true;
+}
+
 
 //------------------------------------------------------------------------------
 /**
  * @brief FifoDataport constructor
  *
+ * @note a capacity that is a power of two allows calculating buffer indices by
+ * masking instead of a modulo operation, which is a division on most targets
+ *
  * @param self (required) pointer to the FifoDataport context
- * @param capacity (required) capacity in bytes of the FIFO in the dataport
+ * @param capacity (required) capacity in bytes of the FIFO in the dataport,
+ *  must be a power of two if FIFO_DATAPORT_POW2_CAPACITY is defined
  *
  * @retval true if succeeded
  */
@@ -53,9 +377,33 @@ FifoDataport_ctor(
     FifoDataport* self,
     size_t capacity)
 {
-    return CharFifo_ctor(&self->dataStruct,
-                         self->data,
-                         capacity);
+    return FifoDataport_init(self, capacity, false);
+}
+
+
+//------------------------------------------------------------------------------
+/**
+ * @brief FifoDataport constructor for a data area that is mirrored, i.e. the
+ * memory right after the data area maps the same memory as the data area. Then
+ * FifoDataport_getContiguous() and FifoDataport_getContiguousFree() never stop
+ * at the buffer wrap around, they always return all used or free bytes as one
+ * block.
+ *
+ * @note all sides using the FifoDataport must map the data area mirrored, see
+ * FifoDataportMirror.h for an allocator doing this
+ *
+ * @param self (required) pointer to the FifoDataport context
+ * @param capacity (required) capacity in bytes of the FIFO in the dataport,
+ *  the memory after the data area must mirror these bytes
+ *
+ * @retval true if succeeded
+ */
+static inline bool
+FifoDataport_ctorMirrored(
+    FifoDataport* self,
+    size_t capacity)
+{
+    return FifoDataport_init(self, capacity, true);
 }
 
 
@@ -72,7 +420,12 @@ static inline size_t
 FifoDataport_getSize(
     FifoDataport* self)
 {
-    return CharFifo_getSize(&self->dataStruct);
+    // Load "out" first, so "in" can only be newer and the difference never
+    // underflows, regardless of which side calls this.
+    size_t out = FifoDataport_LOAD_ACQUIRE(&self->consumer.out);
+    size_t in = FifoDataport_LOAD_ACQUIRE(&self->producer.in);
+
+    return in - out;
 }
 
 
@@ -90,7 +443,93 @@ static inline size_t
 FifoDataport_getCapacity(
     FifoDataport* self)
 {
-    return CharFifo_getCapacity(&self->dataStruct);
+    return self->config.capacity;
+}
+
+
+//------------------------------------------------------------------------------
+/**
+ * @brief sets the amount of free bytes that must be reached before the
+ * consumer wakes up a producer blocked in FifoDataport_waitSpace(), see
+ * FifoDataport_removeAndNotify(). A higher value means fewer wakeups for the
+ * producer, but it should not be less than the amounts the producer waits for.
+ * To be called by the producer right after the constructor.
+ *
+ * @param self (required) pointer to the FifoDataport context
+ * @param lowWater (required) amount of free bytes, between 1 (default) and the
+ *  capacity
+ */
+static inline void
+FifoDataport_setLowWater(
+    FifoDataport* self,
+    size_t lowWater)
+{
+    size_t capacity = FifoDataport_getCapacity(self);
+
+    if (0 == lowWater)
+    {
+        lowWater = 1;
+    }
+    else if (lowWater > capacity)
+    {
+        lowWater = capacity;
+    }
+
+    // The consumer may already be looking at the dataport.
+    __atomic_store_n(&self->config.lowWater, lowWater, __ATOMIC_RELAXED);
+}
+
+
+//------------------------------------------------------------------------------
+// Returns the buffer index for a position given by "in" or "out".
+static inline size_t
+FifoDataport_toIndex(
+    FifoDataport* self,
+    size_t pos)
+{
+#ifndef FIFO_DATAPORT_POW2_CAPACITY
+
+    // A capacity of 1 has a mask of 0 and ends up here, too. This is fine.
+    if (0 == self->config.mask)
+    {
+        return pos % self->config.capacity;
+    }
+
+#endif
+
+    return pos & self->config.mask;
+}
+
+
+//------------------------------------------------------------------------------
+// Returns the buffer index "amount" bytes after the given buffer index, with
+// "amount" being at most the capacity.
+static inline size_t
+FifoDataport_advance(
+    FifoDataport* self,
+    size_t index,
+    size_t amount)
+{
+    size_t updated = index + amount;
+
+#ifndef FIFO_DATAPORT_POW2_CAPACITY
+
+    // Since "index" and "amount" are at most the capacity, we can avoid a
+    // potentially expensive modulo operation.
+    if (0 == self->config.mask)
+    {
+        size_t capacity = FifoDataport_getCapacity(self);
+        if (updated >= capacity)
+        {
+            updated -= capacity;
+            assert(updated < capacity);
+        }
+        return updated;
+    }
+
+#endif
+
+    return updated & self->config.mask;
 }
 
 
@@ -128,7 +567,7 @@ static inline bool
 FifoDataport_isEmpty(
     FifoDataport* self)
 {
-    return CharFifo_isEmpty(&self->dataStruct);
+    return (0 == FifoDataport_getSize(self));
 }
 
 
@@ -144,7 +583,297 @@ static inline bool
 FifoDataport_isFull(
     FifoDataport* self)
 {
-    return CharFifo_isFull(&self->dataStruct);
+    return (FifoDataport_getSize(self) == FifoDataport_getCapacity(self));
+}
+
+
+//------------------------------------------------------------------------------
+// Consumer side only. Returns the consumer's copy of "in", which is refreshed
+// from the producer's cache line only if it does not cover at least "wanted"
+// bytes, SIZE_MAX always refreshes it. Since the copy was loaded with acquire
+// semantics, all data up to it is visible to the consumer.
+static inline size_t
+FifoDataport_syncIn(
+    FifoDataport* self,
+    size_t wanted)
+{
+    size_t in = self->consumer.inSeen;
+    if ((in - self->consumer.out) < wanted)
+    {
+        in = FifoDataport_LOAD_ACQUIRE(&self->producer.in);
+        self->consumer.inSeen = in;
+    }
+    return in;
+}
+
+
+//------------------------------------------------------------------------------
+// Producer side only. Returns the producer's copy of "out", which is refreshed
+// from the consumer's cache line only if the free space it leaves is less than
+// "wanted" bytes, SIZE_MAX always refreshes it.
+static inline size_t
+FifoDataport_syncOut(
+    FifoDataport* self,
+    size_t wanted)
+{
+    size_t out = self->producer.outSeen;
+    size_t capacity = FifoDataport_getCapacity(self);
+    if ((capacity - (self->producer.in - out)) < wanted)
+    {
+        out = FifoDataport_LOAD_ACQUIRE(&self->consumer.out);
+        self->producer.outSeen = out;
+    }
+    return out;
+}
+
+
+//------------------------------------------------------------------------------
+// Producer side only. Accounts "amount" bytes that are about to be published
+// in the statistics, to be called before "in" is updated.
+static inline void
+FifoDataport_statsAdded(
+    FifoDataport* self,
+    size_t amount)
+{
+#ifdef FIFO_DATAPORT_STATISTICS
+
+    // Our copy of "out" may be outdated by far, so the consumer's index is
+    // loaded here to get a meaningful occupancy.
+    size_t capacity = FifoDataport_getCapacity(self);
+    size_t used = FifoDataport_LOAD_RELAXED(&self->producer.in) + amount
+                  - FifoDataport_LOAD_RELAXED(&self->consumer.out);
+    if (used > capacity)
+    {
+        used = capacity;
+    }
+
+    size_t binSize = (capacity + FifoDataport_STATS_HISTOGRAM_BINS - 1)
+                     / FifoDataport_STATS_HISTOGRAM_BINS;
+    size_t bin = used / binSize;
+    if (bin >= FifoDataport_STATS_HISTOGRAM_BINS)
+    {
+        bin = FifoDataport_STATS_HISTOGRAM_BINS - 1;
+    }
+
+    FifoDataport_STATS_ADD(self->producerStats.bytesIn, amount);
+    FifoDataport_STATS_ADD(self->producerStats.histogram[bin], 1);
+    if (used > FifoDataport_LOAD_RELAXED(&self->producerStats.highWater))
+    {
+        __atomic_store_n(&self->producerStats.highWater, used,
+                         __ATOMIC_RELAXED);
+    }
+
+#else
+
+    (void)self;
+    (void)amount;
+
+#endif
+}
+
+
+//------------------------------------------------------------------------------
+// Consumer side only. Accounts "amount" bytes that are removed in the
+// statistics.
+static inline void
+FifoDataport_statsRemoved(
+    FifoDataport* self,
+    size_t amount)
+{
+#ifdef FIFO_DATAPORT_STATISTICS
+
+    FifoDataport_STATS_ADD(self->consumerStats.bytesOut, amount);
+
+#else
+
+    (void)self;
+    (void)amount;
+
+#endif
+}
+
+
+//------------------------------------------------------------------------------
+// Producer side only. Stamps a chunk, "in" is the value of "in" once the chunk
+// has been added.
+static inline void
+FifoDataport_latencyStamp(
+    FifoDataport* self,
+    size_t in)
+{
+#ifdef FIFO_DATAPORT_LATENCY
+
+    size_t stamp = self->latencyProducer.in;
+    if ((stamp - FifoDataport_LOAD_ACQUIRE(&self->latencyConsumer.out))
+        >= FifoDataport_LATENCY_STAMPS)
+    {
+        FifoDataport_COUNTER_ADD(self->latencyProducer.dropped, 1);
+        return;
+    }
+
+    size_t i = stamp % FifoDataport_LATENCY_STAMPS;
+    self->latencyProducer.stamps[i].pos = in;
+    self->latencyProducer.stamps[i].time = FifoDataport_LATENCY_NOW();
+    FifoDataport_STORE_RELEASE(&self->latencyProducer.in, stamp + 1);
+
+#else
+
+    (void)self;
+    (void)in;
+
+#endif
+}
+
+
+//------------------------------------------------------------------------------
+// Returns the bin of the latency histogram for a delay.
+static inline size_t
+FifoDataport_getLatencyBin(
+    uint64_t delay)
+{
+    const uint64_t sub = (uint64_t)1 << FifoDataport_LATENCY_SUB_BITS;
+
+    if (delay < sub)
+    {
+        return (size_t)delay;
+    }
+
+    // The highest bit selects the power of two, the bits below it the bin
+    // within.
+    size_t msb = 63 - (size_t)__builtin_clzll(delay);
+    size_t shift = msb - FifoDataport_LATENCY_SUB_BITS;
+    return ((shift + 1) << FifoDataport_LATENCY_SUB_BITS)
+           + (size_t)((delay >> shift) & (sub - 1));
+}
+
+
+//------------------------------------------------------------------------------
+// Consumer side only. Takes the stamps of all chunks that have been removed
+// completely, "out" is the value of "out" once the bytes have been removed.
+static inline void
+FifoDataport_latencyTake(
+    FifoDataport* self,
+    size_t out)
+{
+#ifdef FIFO_DATAPORT_LATENCY
+
+    size_t stamp = self->latencyConsumer.out;
+    size_t stamped = FifoDataport_LOAD_ACQUIRE(&self->latencyProducer.in);
+    uint64_t now = 0;
+
+    // The positions wrap around like the indices, so they are compared by
+    // their difference.
+    while ((stamp != stamped)
+           && ((ptrdiff_t)(self->latencyProducer.stamps[
+                   stamp % FifoDataport_LATENCY_STAMPS].pos - out) <= 0))
+    {
+        // The clock is read only if there is anything to measure.
+        if (0 == now)
+        {
+            now = FifoDataport_LATENCY_NOW();
+        }
+
+        uint64_t delay = now - self->latencyProducer.stamps[
+                             stamp % FifoDataport_LATENCY_STAMPS].time;
+        FifoDataport_COUNTER_ADD(self->latencyConsumer.histogram[
+                                     FifoDataport_getLatencyBin(delay)], 1);
+        if (delay > self->latencyConsumer.max)
+        {
+            __atomic_store_n(&self->latencyConsumer.max, delay,
+                             __ATOMIC_RELAXED);
+        }
+        stamp++;
+    }
+
+    FifoDataport_STORE_RELEASE(&self->latencyConsumer.out, stamp);
+
+#else
+
+    (void)self;
+    (void)out;
+
+#endif
+}
+
+
+//------------------------------------------------------------------------------
+// Consumer side only. Works like FifoDataport_getContiguous(), but the
+// producer's index is read only if our copy of it does not cover "wanted"
+// bytes.
+static inline size_t
+FifoDataport_getContiguousCached(
+    FifoDataport* self,
+    void** buffer,
+    size_t wanted)
+{
+    // +-----------+----------+-----------+
+    // |<--free2-->|<--used-->|<--free1-->|
+    // +-----------+----------+-----------+
+    //           first       last
+    //
+    // +-----------+-----------+
+    // |<--used2-->|<--used1-->|  isFull
+    // |<--free2-->|<--free1-->|  isEmpty
+    // +-----------+-----------+
+    //        first/last
+    //
+    // +-----------+----------+-----------+
+    // |<--used2-->|<--free-->|<--used1-->|
+    // +-----------+----------+-----------+
+    // |          last      first         |
+    //
+    // The caller wants to get ("lock") a buffer with data in the FIFO, so it
+    // can access it without immediately removing it from the FIFO. This can be
+    // useful for zero-copy operations. In parallel another thread may add data
+    // to the FIFO. This is not a problem as long as we keep working on the
+    // snapshot taken from the FIFO. The producer's index is read only if our
+    // copy of it does not cover "wanted" bytes.
+    size_t in = FifoDataport_syncIn(self, wanted);
+    size_t out = self->consumer.out;
+
+    // FIFO empty?
+    if (in == out)
+    {
+        FifoDataport_STATS_ADD(self->consumerStats.emptyHits, 1);
+        if (buffer)
+        {
+            *buffer = NULL;
+        }
+        return 0;
+    }
+
+    // Reading "first" is safe, because a thread putting data into the FIFO in
+    // parallel will not modify it.
+    size_t first = self->consumer.first;
+
+    if (buffer)
+    {
+        *buffer = &self->data[first];
+    }
+
+    // A mirrored data area continues seamlessly after its end.
+    if (self->config.mirrored)
+    {
+        return in - out;
+    }
+
+    // self->producer.last may have changed already, so we can't use it here
+    size_t capacity = FifoDataport_getCapacity(self);
+    size_t last = FifoDataport_toIndex(self, in);
+
+#ifdef FIFO_DATAPORT_STATISTICS
+
+    // Only if "in" has just been reloaded, a different "last" means that the
+    // producer is adding data right now and not that our copy of "in" is old.
+    if ((SIZE_MAX == wanted)
+        && (last != FifoDataport_LOAD_RELAXED(&self->producer.last)))
+    {
+        FifoDataport_STATS_ADD(self->consumerStats.concurrentChanges, 1);
+    }
+
+#endif
+
+    return (first < last) ? last - first : capacity - first;
 }
 
 
@@ -172,6 +901,47 @@ static inline size_t
 FifoDataport_getContiguous(
     FifoDataport* self,
     void** buffer)
+{
+    // The producer's index is always read, so the snapshot covers all data
+    // added so far, even if the caller leaves data in the FIFO until more has
+    // arrived.
+    return FifoDataport_getContiguousCached(self, buffer, SIZE_MAX);
+}
+
+
+//------------------------------------------------------------------------------
+// This is deprecated, use FifoDataport_getContiguous() directly to get the
+// buffer and the size atomically and avoid race conditions.
+static inline void const*
+FifoDataport_getFirst(
+    FifoDataport* self)
+{
+    void* buffer = NULL;
+    FifoDataport_getContiguous(self, &buffer);
+    return buffer; // NULL if FIFO is empty
+}
+
+
+//------------------------------------------------------------------------------
+// This is deprecated, use FifoDataport_getContiguous() directly to get the
+// buffer and the size atomically and avoid race conditions.
+static inline size_t
+FifoDataport_getAmountConsecutives(
+    FifoDataport* self)
+{
+    return FifoDataport_getContiguous(self, NULL);
+}
+
+
+//------------------------------------------------------------------------------
+// Producer side only. Works like FifoDataport_getContiguousFree(), but the
+// consumer's index is read only if our copy of it does not leave room for
+// "wanted" bytes.
+static inline size_t
+FifoDataport_getContiguousFreeCached(
+    FifoDataport* self,
+    void** buffer,
+    size_t wanted)
 {
     // +-----------+----------+-----------+
     // |<--free2-->|<--used-->|<--free1-->|
@@ -189,17 +959,20 @@ FifoDataport_getContiguous(
     // +-----------+----------+-----------+
     // |          last      first         |
     //
-    // The caller wants to get ("lock") a buffer with data in the FIFO, so it
-    // can access it without immediately removing it from the FIFO. This can be
-    // useful for zero-copy operations. In parallel another thread may add data
-    // to the FIFO. This is not a problem as long as we keep working on the
-    // snapshot taken from the FIFO.
-    size_t in = self->dataStruct.in;
-    size_t out = self->dataStruct.out;
+    // The caller wants to get ("lock") an empty part of the FIFO, so it can
+    // put data there as a block, e.g. for DMA or avoiding intermediate buffers
+    // and memcpy(). In parallel another thread may remove data to the FIFO.
+    // This is not a problem as long as we keep working on the snapshot taken
+    // from the FIFO. The consumer's index is read only if our copy of it does
+    // not leave room for "wanted" bytes.
+    size_t capacity = FifoDataport_getCapacity(self);
+    size_t in = self->producer.in;
+    size_t out = FifoDataport_syncOut(self, wanted);
 
-    // FIFO empty?
-    if (in == out)
+    // FIFO full ?
+    if ((out + capacity) == in)
     {
+        FifoDataport_STATS_ADD(self->producerStats.fullHits, 1);
         if (buffer)
         {
             *buffer = NULL;
@@ -207,144 +980,374 @@ FifoDataport_getContiguous(
         return 0;
     }
 
-    // Reading "first" is safe, because a thread putting data into the FIFO in
+    // Reading "last" is safe, because a thread removing data from the FIFO in
     // parallel will not modify it.
-    size_t first = self->dataStruct.first;
+    size_t last = self->producer.last;
+
+    if (buffer)
+    {
+        *buffer = &self->data[last];
+    }
+
+    // A mirrored data area continues seamlessly after its end.
+    if (self->config.mirrored)
+    {
+        return capacity - (in - out);
+    }
+
+    // self->consumer.first may have changed already, so we can't use it here
+    size_t first = FifoDataport_toIndex(self, out);
+
+#ifdef FIFO_DATAPORT_STATISTICS
+
+    // Only if "out" has just been reloaded, a different "first" means that the
+    // consumer is removing data right now and not that our copy of "out" is
+    // old.
+    if ((SIZE_MAX == wanted)
+        && (first != FifoDataport_LOAD_RELAXED(&self->consumer.first)))
+    {
+        FifoDataport_STATS_ADD(self->producerStats.concurrentChanges, 1);
+    }
+
+#endif
+
+    return (first > last) ? first - last : capacity - last;
+}
+
+
+//------------------------------------------------------------------------------
+/**
+ * @brief provides a pointer to the FIFO buffer in the dataport to the first
+ * available location for new bytes according to the FIFO policy and returns the
+ * amount of available byte locations from there until the buffer wrap around
+ *
+ * @note this is useful for 0-copy operations as that memory space could be
+ * filled using, for example, memcpy() or DMA
+ *
+ * @note the amount of contiguous available locations is not necessarily the
+ * same as returned by FifoDataport_getCapacity(), it can be less
+ *
+ * @param self (required) pointer to the FifoDataport context
+ * @param buffer (optional) pointer to a pointer that will be set to the first
+ * available location for new bytes according to the FIFO policy, it could be
+ * set to NULL by the caller if not interested in getting this information
+ *
+ * @return amount of available byte locations from the first available location
+ * for new bytes until the buffer wrap around
+ */
+static inline size_t
+FifoDataport_getContiguousFree(
+    FifoDataport* self,
+    void** buffer)
+{
+    // The consumer's index is always read, so the snapshot covers all space
+    // freed so far, even if the caller waits for more.
+    return FifoDataport_getContiguousFreeCached(self, buffer, SIZE_MAX);
+}
+
+
+//------------------------------------------------------------------------------
+// Fills the two segments for a block of "amount" bytes starting at the buffer
+// index "index", the second one is used if the block wraps around.
+static inline void
+FifoDataport_splitSegments(
+    FifoDataport* self,
+    size_t index,
+    size_t amount,
+    FifoDataport_Segment segments[2])
+{
+    size_t capacity = FifoDataport_getCapacity(self);
+    size_t toEnd = self->config.mirrored ? amount : capacity - index;
+    size_t len = (amount < toEnd) ? amount : toEnd;
+
+    segments[0].buffer = (len > 0) ? &self->data[index] : NULL;
+    segments[0].len = len;
+    segments[1].buffer = (amount > len) ? self->data : NULL;
+    segments[1].len = amount - len;
+}
+
+
+//------------------------------------------------------------------------------
+/**
+ * @brief copies a block with non-temporal (streaming) stores, which don't pull
+ * the destination into the cache of the caller. All stores are complete when
+ * this returns, so the data can be published right away. On targets without
+ * such stores this is a plain memcpy().
+ *
+ * @param dst (required) destination buffer
+ * @param src (required) source buffer
+ * @param len (required) amount of bytes to copy
+ */
+static inline void
+FifoDataport_copyStreaming(
+    void* dst,
+    void const* src,
+    size_t len)
+{
+#if defined(__SSE2__)
+
+    char*       target = dst;
+    char const* source = src;
+
+    // Streaming stores need an aligned destination, the unaligned head is
+    // copied the normal way.
+    size_t head = (16 - ((uintptr_t)target & 15)) & 15;
+    if (head > len)
+    {
+        head = len;
+    }
+    memcpy(target, source, head);
+    target += head;
+    source += head;
+    len    -= head;
+
+    for (; len >= 64; len -= 64, target += 64, source += 64)
+    {
+        __m128i a = _mm_loadu_si128((const __m128i*)&source[0]);
+        __m128i b = _mm_loadu_si128((const __m128i*)&source[16]);
+        __m128i c = _mm_loadu_si128((const __m128i*)&source[32]);
+        __m128i d = _mm_loadu_si128((const __m128i*)&source[48]);
+        _mm_stream_si128((__m128i*)&target[0], a);
+        _mm_stream_si128((__m128i*)&target[16], b);
+        _mm_stream_si128((__m128i*)&target[32], c);
+        _mm_stream_si128((__m128i*)&target[48], d);
+    }
+    for (; len >= 16; len -= 16, target += 16, source += 16)
+    {
+        _mm_stream_si128((__m128i*)target,
+                         _mm_loadu_si128((const __m128i*)source));
+    }
+    memcpy(target, source, len);
+
+    // Streaming stores are weakly ordered, they must be complete before the
+    // release store of "in" publishes the data.
+    _mm_sfence();
+
+#else
+
+    memcpy(dst, src, len);
+
+#endif
+}
+
+
+//------------------------------------------------------------------------------
+/**
+ * @brief sets the size from which copies into the FIFO use non-temporal stores,
+ * see FifoDataport_copyStreaming(). This pays off for large transfers when
+ * the consumer runs on another core, since it does not have to take each
+ * cache line back from the producer's cache. To be called by the producer.
+ *
+ * @param self (required) pointer to the FifoDataport context
+ * @param threshold (required) size of a copy in bytes, 0 (default) disables
+ *  non-temporal stores
+ */
+static inline void
+FifoDataport_setStreamingThreshold(
+    FifoDataport* self,
+    size_t threshold)
+{
+    self->producer.streamThreshold = threshold;
+}
+
+
+//------------------------------------------------------------------------------
+// Producer side only. Copies data into the FIFO buffer, large blocks bypass the
+// cache if configured by FifoDataport_setStreamingThreshold().
+static inline void
+FifoDataport_copyIn(
+    FifoDataport* self,
+    void* dst,
+    void const* src,
+    size_t len)
+{
+    size_t threshold = self->producer.streamThreshold;
+
+    if ((0 != threshold) && (len >= threshold))
+    {
+        FifoDataport_copyStreaming(dst, src, len);
+        return;
+    }
+    memcpy(dst, src, len);
+}
+
+
+//------------------------------------------------------------------------------
+// Consumer side only. Works like FifoDataport_getSegments(), but the
+// producer's index is read only if our copy of it does not cover "wanted"
+// bytes.
+static inline size_t
+FifoDataport_getSegmentsCached(
+    FifoDataport* self,
+    FifoDataport_Segment segments[2],
+    size_t wanted)
+{
+    size_t used = FifoDataport_syncIn(self, wanted) - self->consumer.out;
+    if (0 == used)
+    {
+        FifoDataport_STATS_ADD(self->consumerStats.emptyHits, 1);
+    }
+
+    FifoDataport_splitSegments(self, self->consumer.first, used, segments);
+    return used;
+}
+
+
+//------------------------------------------------------------------------------
+/**
+ * @brief provides all bytes available in the FIFO in the dataport as up to two
+ * segments, the second segment is used if the data wraps around at the end of
+ * the buffer. Both segments come from the same snapshot of the FIFO indices.
+ *
+ * @note this is useful for 0-copy operations that take scatter lists, e.g.
+ * DMA or writev()
+ *
+ * @param self (required) pointer to the FifoDataport context
+ * @param segments (required) array of two segments that will be set to the
+ * available data, unused segments have a NULL buffer and a length of 0
+ *
+ * @return total amount of bytes in both segments
+ */
+static inline size_t
+FifoDataport_getSegments(
+    FifoDataport* self,
+    FifoDataport_Segment segments[2])
+{
+    // Like FifoDataport_getContiguous(), this always reads the producer's
+    // index.
+    return FifoDataport_getSegmentsCached(self, segments, SIZE_MAX);
+}
 
-    if (buffer)
-    {
-        *buffer = &self->data[first];
-    }
 
-    // self->dataStruct.last may have changed already, so we can't use it here
+//------------------------------------------------------------------------------
+// Producer side only. Works like FifoDataport_getSegmentsFree(), but the
+// consumer's index is read only if our copy of it does not leave room for
+// "wanted" bytes.
+static inline size_t
+FifoDataport_getSegmentsFreeCached(
+    FifoDataport* self,
+    FifoDataport_Segment segments[2],
+    size_t wanted)
+{
     size_t capacity = FifoDataport_getCapacity(self);
-    size_t last = in % capacity;
-
-#ifdef FIFO_DATAPORT_PROFILING
-
-    size_t mem_last = self->dataStruct.last;
-    if (last != mem_last)
+    size_t free = capacity
+                  - (self->producer.in - FifoDataport_syncOut(self, wanted));
+    if (0 == free)
     {
-        Debug_LOG_INFO(
-            "change due to concurrency: index 'last': %zu -> %zu, data 'in' %zu -> %zu",
-            last, mem_last, in, self->dataStruct.in);
+        FifoDataport_STATS_ADD(self->producerStats.fullHits, 1);
     }
 
-#endif
-
-    return (first < last) ? last - first : capacity - first;
+    FifoDataport_splitSegments(self, self->producer.last, free, segments);
+    return free;
 }
 
 
 //------------------------------------------------------------------------------
-// This is deprecated, use FifoDataport_getContiguous() directly to get the
-// buffer and the size atomically and avoid race conditions.
-static inline void const*
-FifoDataport_getFirst(
-    FifoDataport* self)
+/**
+ * @brief provides all free byte locations in the FIFO in the dataport as up to
+ * two segments, the second segment is used if the free space wraps around at
+ * the end of the buffer. Both segments come from the same snapshot of the FIFO
+ * indices.
+ *
+ * @note this is useful for 0-copy operations that take scatter lists, e.g.
+ * DMA or readv()
+ *
+ * @param self (required) pointer to the FifoDataport context
+ * @param segments (required) array of two segments that will be set to the
+ * free space, unused segments have a NULL buffer and a length of 0
+ *
+ * @return total amount of byte locations in both segments
+ */
+static inline size_t
+FifoDataport_getSegmentsFree(
+    FifoDataport* self,
+    FifoDataport_Segment segments[2])
 {
-    void* buffer = NULL;
-    FifoDataport_getContiguous(self, &buffer);
-    return buffer; // NULL if FIFO is empty
+    // Like FifoDataport_getContiguousFree(), this always reads the consumer's
+    // index.
+    return FifoDataport_getSegmentsFreeCached(self, segments, SIZE_MAX);
 }
 
 
 //------------------------------------------------------------------------------
-// This is deprecated, use FifoDataport_getContiguous() directly to get the
-// buffer and the size atomically and avoid race conditions.
+/**
+ * @brief provides bytes available in the FIFO in the dataport at a given offset
+ * from the first available byte as up to two segments, without removing
+ * anything from the FIFO
+ *
+ * @note this is useful for parsers that have to look at a header before they
+ * know whether a record is complete, the data is then removed with
+ * FifoDataport_remove()
+ *
+ * @param self (required) pointer to the FifoDataport context
+ * @param offset (required) offset from the first available byte
+ * @param len (required) maximum amount of bytes wanted
+ * @param segments (required) array of two segments that will be set to the
+ * data, unused segments have a NULL buffer and a length of 0
+ *
+ * @return total amount of bytes in both segments, less than len if the FIFO
+ * does not contain enough data
+ */
 static inline size_t
-FifoDataport_getAmountConsecutives(
-    FifoDataport* self)
+FifoDataport_peekSegments(
+    FifoDataport* self,
+    size_t offset,
+    size_t len,
+    FifoDataport_Segment segments[2])
 {
-    return FifoDataport_getContiguous(self, NULL);
+    size_t wanted = (len > SIZE_MAX - offset) ? SIZE_MAX : offset + len;
+    size_t used = FifoDataport_syncIn(self, wanted) - self->consumer.out;
+    size_t amount = 0;
+    size_t index = self->consumer.first;
+
+    if (offset < used)
+    {
+        amount = ((used - offset) < len) ? used - offset : len;
+        index = FifoDataport_advance(self, index, offset);
+    }
+
+    FifoDataport_splitSegments(self, index, amount, segments);
+    return amount;
 }
 
 
 //------------------------------------------------------------------------------
 /**
- * @brief provides a pointer to the FIFO buffer in the dataport to the first
- * available location for new bytes according to the FIFO policy and returns the
- * amount of available byte locations from there until the buffer wrap around
- *
- * @note this is useful for 0-copy operations as that memory space could be
- * filled using, for example, memcpy() or DMA
- *
- * @note the amount of contiguous available locations is not necessarily the
- * same as returned by FifoDataport_getCapacity(), it can be less
+ * @brief copies a certain amount of bytes at a given offset from the first
+ * available byte in the FIFO in the dataport to a given buffer, without
+ * removing anything from the FIFO
  *
  * @param self (required) pointer to the FifoDataport context
- * @param buffer (optional) pointer to a pointer that will be set to the first
- * available location for new bytes according to the FIFO policy, it could be
- * set to NULL by the caller if not interested in getting this information
+ * @param offset (required) offset from the first available byte
+ * @param buf (required) pointer to the destination buffer
+ * @param len (required) maximum amount of bytes that buf could take
  *
- * @return amount of available byte locations from the first available location
- * for new bytes until the buffer wrap around
+ * @return the amount of bytes which have been actually copied
  */
 static inline size_t
-FifoDataport_getContiguousFree(
+FifoDataport_peek(
     FifoDataport* self,
-    void** buffer)
+    size_t offset,
+    void* buf,
+    size_t len)
 {
-    // +-----------+----------+-----------+
-    // |<--free2-->|<--used-->|<--free1-->|
-    // +-----------+----------+-----------+
-    //           first       last
-    //
-    // +-----------+-----------+
-    // |<--used2-->|<--used1-->|  isFull
-    // |<--free2-->|<--free1-->|  isEmpty
-    // +-----------+-----------+
-    //        first/last
-    //
-    // +-----------+----------+-----------+
-    // |<--used2-->|<--free-->|<--used1-->|
-    // +-----------+----------+-----------+
-    // |          last      first         |
-    //
-    // The caller wants to get ("lock") an empty part of the FIFO, so it can
-    // put data there as a block, e.g. for DMA or avoiding intermediate buffers
-    // and memcpy(). In parallel another thread may remove data to the FIFO.
-    // This is not a problem as long as we keep working on the snapshot taken
-    // from the FIFO.
-    size_t capacity = FifoDataport_getCapacity(self);
-    size_t in = self->dataStruct.in;
-    size_t out = self->dataStruct.out;
+    char* target = buf;
 
-    // FIFO full ?
-    if ((out + capacity) == in)
+    if ((NULL == target) || (0 == len))
     {
-        if (buffer)
-        {
-            *buffer = NULL;
-        }
         return 0;
     }
 
-    // Reading "last" is safe, because a thread removing data from the FIFO in
-    // parallel will not modify it.
-    size_t last = self->dataStruct.last;
-
-    if (buffer)
-    {
-        *buffer = &self->data[last];
-    }
-
-    // self->dataStruct.first may have changed already, so we can't use it here
-    size_t first = out % capacity;
-
-#ifdef FIFO_DATAPORT_PROFILING
+    FifoDataport_Segment segments[2];
+    size_t amount = FifoDataport_peekSegments(self, offset, len, segments);
 
-    size_t mem_first = self->dataStruct.first;
-    if (first != mem_first)
+    for (size_t i = 0; (i < 2) && (segments[i].len > 0); i++)
     {
-        Debug_LOG_INFO(
-            "change due to concurrency: index 'first': %zu -> %zu, data 'out' %zu -> %zu",
-            first, mem_first, out, self->dataStruct.out);
+        memcpy(target, segments[i].buffer, segments[i].len);
+        target += segments[i].len;
     }
 
-#endif
-
-    return (first > last) ? first - last : capacity - last;
+    return amount;
 }
 
 
@@ -364,29 +1367,24 @@ FifoDataport_remove(
     FifoDataport* self,
     size_t amount)
 {
-    size_t used = FifoDataport_getSize(self);
+    size_t used = FifoDataport_syncIn(self, amount) - self->consumer.out;
     if (amount > used)
     {
         Debug_LOG_ERROR("FifoDataport_remove() amount %zu > used %zu", amount, used);
         assert(0);
     }
 
-    // We don't loop over calling the FifoT's function CharFifo_pop(), because
-    // we know that char_dtor() does nothing for a char FIFO. So we can just
-    // modify the fields directly.
     // The used bytes in the FIFO (aka "size") are calculated based on the
     // fields "in" and "out". The fields "first" and "last" are used only for
-    // addressing data. Since we know they are always less than the FIFO
-    // capacity, we can avoid a potentially expensive modulo operation.
-    size_t capacity = FifoDataport_getCapacity(self);
-    size_t updated_first = self->dataStruct.first + amount;
-    if (updated_first >= capacity)
-    {
-        updated_first -= capacity;
-        assert(updated_first < capacity);
-    }
-    self->dataStruct.first = updated_first;
-    self->dataStruct.out += amount;
+    // addressing data.
+    self->consumer.first = FifoDataport_advance(self,
+                                                self->consumer.first,
+                                                amount);
+    FifoDataport_statsRemoved(self, amount);
+    FifoDataport_latencyTake(self, self->consumer.out + amount);
+    // Release the space to the producer only after we are done with the data.
+    FifoDataport_STORE_RELEASE(&self->consumer.out,
+                               self->consumer.out + amount);
 }
 
 
@@ -407,7 +1405,9 @@ FifoDataport_add(
     FifoDataport* self,
     size_t amount)
 {
-    size_t free = FifoDataport_getFree(self);
+    size_t capacity = FifoDataport_getCapacity(self);
+    size_t free = capacity
+                  - (self->producer.in - FifoDataport_syncOut(self, amount));
     if (amount > free)
     {
         Debug_LOG_ERROR("FifoDataport_add() amount %zu > free %zu", amount, free);
@@ -416,20 +1416,15 @@ FifoDataport_add(
 
     // The used bytes in the FIFO (aka "size") are calculated based on the
     // fields "in" and "out". The fields "first" and "last" are used only for
-    // addressing data. Since we know they are always less than the FIFO
-    // capacity, we can avoid a potentially expensive modulo operation. There
-    // is no need to call CharFifo_push() here, because chars aren't objects
-    // that would require special handing.
-    size_t capacity = FifoDataport_getCapacity(self);
-    size_t updated_last = self->dataStruct.last + amount;
-    if (updated_last >= capacity)
-    {
-        updated_last -= capacity;
-        assert(updated_last < capacity);
-    }
-    self->dataStruct.last = updated_last;
-    self->dataStruct.in += amount;
-
+    // addressing data.
+    self->producer.last = FifoDataport_advance(self,
+                                               self->producer.last,
+                                               amount);
+    FifoDataport_statsAdded(self, amount);
+    FifoDataport_latencyStamp(self, self->producer.in + amount);
+    // Publish the data to the consumer only after it has been written.
+    FifoDataport_STORE_RELEASE(&self->producer.in,
+                               self->producer.in + amount);
 }
 
 
@@ -451,21 +1446,37 @@ FifoDataport_read(
     void* buf,
     size_t len)
 {
-    size_t  read   = 0;
-    char*   target = buf;
+    char* target = buf;
+
+    if ((NULL == target) || (0 == len))
+    {
+        return 0;
+    }
 
-    if (target != NULL)
+    // The producer's index is read only if our copy of it does not cover the
+    // whole request.
+    FifoDataport_Segment segments[2];
+    FifoDataport_getSegmentsCached(self, segments, len);
+
+    size_t read = 0;
+    for (size_t i = 0; (i < 2) && (read < len); i++)
     {
-        while (read < len)
+        size_t chunk = len - read;
+        if (chunk > segments[i].len)
+        {
+            chunk = segments[i].len;
+        }
+        if (0 == chunk)
         {
-            const char* source = FifoDataport_getFirst(self);
-            if (NULL == source)
-            {
-                break;
-            }
-            target[read++] = *source;
-            CharFifo_pop(&self->dataStruct);
+            break;
         }
+        memcpy(&target[read], segments[i].buffer, chunk);
+        read += chunk;
+    }
+
+    if (read > 0)
+    {
+        FifoDataport_remove(self, read);
     }
     return read;
 }
@@ -489,21 +1500,336 @@ FifoDataport_write(
     void const* buf,
     size_t len)
 {
-    size_t written      = 0;
-    char const* target  = buf;
+    char const* source = buf;
+
+    if ((NULL == source) || (0 == len))
+    {
+        return 0;
+    }
 
-    if (target != NULL)
+    // The consumer's index is read only if our copy of it does not leave room
+    // for the whole request.
+    FifoDataport_Segment segments[2];
+    FifoDataport_getSegmentsFreeCached(self, segments, len);
+
+    size_t written = 0;
+    for (size_t i = 0; (i < 2) && (written < len); i++)
     {
-        while (written < len
-               && CharFifo_push(&self->dataStruct, &target[written]))
+        size_t chunk = len - written;
+        if (chunk > segments[i].len)
+        {
+            chunk = segments[i].len;
+        }
+        if (0 == chunk)
         {
-            written++;
+            break;
         }
+        FifoDataport_copyIn(self, segments[i].buffer, &source[written], chunk);
+        written += chunk;
+    }
+
+    if (written > 0)
+    {
+        FifoDataport_add(self, written);
     }
     return written;
 }
 
 
+//------------------------------------------------------------------------------
+/**
+ * @brief searches the bytes available in the FIFO in the dataport for the
+ * first occurrence of any of the given delimiters, e.g. a line or record
+ * terminator, without removing anything from the FIFO. Both segments of the
+ * data are searched with vector instructions where the target has them.
+ *
+ * @note the producer's index is always read, so all bytes added so far are
+ * searched
+ *
+ * @param self (required) pointer to the FifoDataport context
+ * @param delims (required) array of delimiter bytes, a single byte or a small
+ * set of them, any byte value including 0 is possible
+ * @param numDelims (required) number of bytes in delims, with none nothing is
+ * searched
+ * @param offset (optional) pointer to a variable that will be set to the offset
+ * of the delimiter from the first available byte or, if no delimiter has been
+ * found, to the amount of bytes searched. It could be set to NULL by the
+ * caller if not interested in getting this information
+ *
+ * @retval true if a delimiter has been found
+ */
+bool
+FifoDataport_find(
+    FifoDataport* self,
+    void const* delims,
+    size_t numDelims,
+    size_t* offset);
+
+
+//------------------------------------------------------------------------------
+/**
+ * @brief moves a certain amount of bytes from one FIFO in a dataport to
+ * another one. The data is copied directly from the used segments of src to
+ * the free segments of dst, followed by a single update of the indices of each
+ * FIFO. To be called by a component that is the consumer of src and the
+ * producer of dst.
+ *
+ * @param src (required) pointer to the FifoDataport context to consume from
+ * @param dst (required) pointer to the FifoDataport context to produce to
+ * @param maxBytes (required) maximum amount of bytes to be moved
+ *
+ * @return the amount of bytes which have been actually moved, limited by the
+ * data in src and the free space in dst
+ */
+static inline size_t
+FifoDataport_relay(
+    FifoDataport* src,
+    FifoDataport* dst,
+    size_t maxBytes)
+{
+    FifoDataport_Segment from[2];
+    FifoDataport_Segment to[2];
+
+    // The peers' indices are read only if our copies of them don't cover the
+    // whole request.
+    size_t amount = FifoDataport_getSegmentsCached(src, from, maxBytes);
+    if (amount > maxBytes)
+    {
+        amount = maxBytes;
+    }
+    size_t free = FifoDataport_getSegmentsFreeCached(dst, to, amount);
+    if (amount > free)
+    {
+        amount = free;
+    }
+
+    // The segments of both FIFOs wrap at different places, so copy the pieces
+    // between any two boundaries.
+    size_t i = 0, fromOffset = 0;
+    size_t j = 0, toOffset = 0;
+    for (size_t done = 0; done < amount; )
+    {
+        size_t chunk = amount - done;
+        if (chunk > from[i].len - fromOffset)
+        {
+            chunk = from[i].len - fromOffset;
+        }
+        if (chunk > to[j].len - toOffset)
+        {
+            chunk = to[j].len - toOffset;
+        }
+
+        FifoDataport_copyIn(dst,
+                            (char*)to[j].buffer + toOffset,
+                            (char const*)from[i].buffer + fromOffset,
+                            chunk);
+        done += chunk;
+
+        fromOffset += chunk;
+        if (fromOffset == from[i].len)
+        {
+            i++;
+            fromOffset = 0;
+        }
+        toOffset += chunk;
+        if (toOffset == to[j].len)
+        {
+            j++;
+            toOffset = 0;
+        }
+    }
+
+    if (amount > 0)
+    {
+        FifoDataport_add(dst, amount);
+        FifoDataport_remove(src, amount);
+    }
+    return amount;
+}
+
+
+//------------------------------------------------------------------------------
+/**
+ * @brief like FifoDataport_relay(), but stops after the first delimiter, which
+ * is moved, too. This way records like lines are forwarded one by one.
+ *
+ * @param src (required) pointer to the FifoDataport context to consume from
+ * @param dst (required) pointer to the FifoDataport context to produce to
+ * @param maxBytes (required) maximum amount of bytes to be moved
+ * @param delims (required) array of delimiter bytes, see FifoDataport_find()
+ * @param numDelims (required) number of bytes in delims, at least one
+ * @param isComplete (optional) pointer to a variable that will be set to true
+ * if the moved bytes end with a delimiter, it could be set to NULL by the
+ * caller if not interested in getting this information
+ *
+ * @return the amount of bytes which have been actually moved
+ */
+static inline size_t
+FifoDataport_relayUntil(
+    FifoDataport* src,
+    FifoDataport* dst,
+    size_t maxBytes,
+    void const* delims,
+    size_t numDelims,
+    bool* isComplete)
+{
+    if (isComplete)
+    {
+        *isComplete = false;
+    }
+    // Without a delimiter nothing would ever be searched and so nothing moved.
+    if (0 == numDelims)
+    {
+        Debug_LOG_ERROR("FifoDataport_relayUntil() no delimiters");
+        return 0;
+    }
+
+    size_t offset = 0;
+    bool isFound = FifoDataport_find(src, delims, numDelims, &offset)
+                   && (offset < maxBytes);
+
+    if (isFound)
+    {
+        maxBytes = offset + 1;
+    }
+    else if (offset < maxBytes)
+    {
+        // Only the bytes searched are moved, the producer may have added more
+        // in the meantime, including a delimiter.
+        maxBytes = offset;
+    }
+
+    size_t moved = FifoDataport_relay(src, dst, maxBytes);
+    if (isComplete)
+    {
+        *isComplete = isFound && (moved == maxBytes);
+    }
+    return moved;
+}
+
+
+//------------------------------------------------------------------------------
+/**
+ * @brief takes a snapshot of the statistics of the FIFO in the dataport, can be
+ * called by both sides
+ *
+ * @note the statistics are available only if FIFO_DATAPORT_STATISTICS is
+ * defined. The counters are taken one by one while the FIFO is in use, so they
+ * need not match each other exactly.
+ *
+ * @param self (required) pointer to the FifoDataport context
+ * @param stats (required) pointer to the snapshot to be filled
+ *
+ * @retval true if succeeded, false if the statistics are not available and the
+ * snapshot has been cleared
+ */
+static inline bool
+FifoDataport_getStatistics(
+    FifoDataport* self,
+    FifoDataport_Statistics* stats)
+{
+#ifdef FIFO_DATAPORT_STATISTICS
+
+    stats->bytesIn =
+        FifoDataport_LOAD_RELAXED(&self->producerStats.bytesIn);
+    stats->bytesOut =
+        FifoDataport_LOAD_RELAXED(&self->consumerStats.bytesOut);
+    stats->fullHits =
+        FifoDataport_LOAD_RELAXED(&self->producerStats.fullHits);
+    stats->emptyHits =
+        FifoDataport_LOAD_RELAXED(&self->consumerStats.emptyHits);
+    stats->highWater =
+        FifoDataport_LOAD_RELAXED(&self->producerStats.highWater);
+    stats->concurrentChanges =
+        FifoDataport_LOAD_RELAXED(&self->producerStats.concurrentChanges)
+        + FifoDataport_LOAD_RELAXED(&self->consumerStats.concurrentChanges);
+
+    for (size_t i = 0; i < FifoDataport_STATS_HISTOGRAM_BINS; i++)
+    {
+        stats->histogram[i] =
+            FifoDataport_LOAD_RELAXED(&self->producerStats.histogram[i]);
+    }
+
+    return true;
+
+#else
+
+    (void)self;
+    memset(stats, 0, sizeof(*stats));
+    return false;
+
+#endif
+}
+
+
+//------------------------------------------------------------------------------
+/**
+ * @brief takes a snapshot of the latency histogram of the FIFO in the
+ * dataport, can be called by both sides. The latency of a chunk is the time
+ * from FifoDataport_add() until its last byte has been removed.
+ *
+ * @note the histogram is available only if FIFO_DATAPORT_LATENCY is defined.
+ * Its unit is that of FifoDataport_LATENCY_NOW(), nanoseconds by default.
+ *
+ * @param self (required) pointer to the FifoDataport context
+ * @param latency (required) pointer to the snapshot to be filled
+ *
+ * @retval true if succeeded, false if the histogram is not available and the
+ * snapshot has been cleared
+ */
+static inline bool
+FifoDataport_getLatency(
+    FifoDataport* self,
+    FifoDataport_Latency* latency)
+{
+#ifdef FIFO_DATAPORT_LATENCY
+
+    for (size_t i = 0; i < FifoDataport_LATENCY_BINS; i++)
+    {
+        latency->histogram[i] =
+            FifoDataport_LOAD_RELAXED(&self->latencyConsumer.histogram[i]);
+    }
+    latency->max = FifoDataport_LOAD_RELAXED(&self->latencyConsumer.max);
+    latency->dropped =
+        FifoDataport_LOAD_RELAXED(&self->latencyProducer.dropped);
+
+    return true;
+
+#else
+
+    (void)self;
+    memset(latency, 0, sizeof(*latency));
+    return false;
+
+#endif
+}
+
+
+//------------------------------------------------------------------------------
+/**
+ * @brief returns the smallest latency counted in a bin of the latency
+ * histogram, the bin covers all values up to the one of the next bin
+ *
+ * @param bin (required) index of the bin
+ *
+ * @return lower bound of the bin
+ */
+static inline uint64_t
+FifoDataport_getLatencyBinValue(
+    size_t bin)
+{
+    const size_t sub = (size_t)1 << FifoDataport_LATENCY_SUB_BITS;
+
+    if (bin < sub)
+    {
+        return bin;
+    }
+
+    size_t shift = (bin >> FifoDataport_LATENCY_SUB_BITS) - 1;
+    return (uint64_t)(sub + (bin & (sub - 1))) << shift;
+}
+
+
 //------------------------------------------------------------------------------
 /**
  * @brief FifoDataport destructor
@@ -514,5 +1840,6 @@ static inline void
 FifoDataport_dtor(
     FifoDataport* self)
 {
-    CharFifo_dtor(&self->dataStruct);
+    // nothing to release, the memory belongs to the dataport
+    (void)self;
 }
@@ -0,0 +1,443 @@
+/*
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/**
+ * @brief Broadcast FIFO for bytes in a dataport.
+ * One producer writes the data once and every consumer reads all of it through
+ * its own read cursor. The free space for the producer is the minimum over the
+ * cursors of the active consumers. The dataport buffer is organised in the
+ * following way, with each block starting on its own cache line:
+ *  __________________________________________________________________________
+ * | ----------|-----------|-----|-----------|----------|--------|----------- |
+ * || producer | cursor[0] | ... | cursor[n] | requests | config |    data   ||
+ * | ----------|-----------|-----|-----------|----------|--------|----------- |
+ * |__________________________________________________________________________|
+ *
+ * A consumer joins with FifoDataportBroadcast_join(). The producer activates it
+ * on its next write, from then on the consumer gets all data written after
+ * that. If the FIFO is created with "evictLagging", the producer never blocks
+ * on a slow consumer: when a write does not fit, consumers that are in the way
+ * are evicted and the data is overwritten. An evicted consumer gets no more
+ * data until it joins again. A read that raced with its eviction is detected
+ * and discarded.
+ *
+ * @note The FifoDataportBroadcast is supposed to be created by the Producer,
+ * the capacity must be a power of two.
+ *
+ */
+#pragma once
+
+#include "lib_io/FifoDataport.h"
+
+#include <stdint.h>
+
+#if !defined(FifoDataportBroadcast_MAX_CONSUMERS)
+#define FifoDataportBroadcast_MAX_CONSUMERS     8
+#endif
+
+typedef enum
+{
+    FifoDataportBroadcast_State_INACTIVE = 0,
+    FifoDataportBroadcast_State_JOINING,
+    FifoDataportBroadcast_State_ACTIVE,
+    FifoDataportBroadcast_State_EVICTED
+}
+FifoDataportBroadcast_State;
+
+// written by the consumer, except for the state changes done by the producer
+typedef struct
+{
+    size_t   out;       // total amount of bytes ever read by this consumer
+    size_t   inSeen;    // last value of "in" loaded by this consumer
+    uint32_t state;     // FifoDataportBroadcast_State
+}
+__attribute__((aligned(FifoDataport_CACHE_LINE_SIZE)))
+FifoDataportBroadcast_Cursor;
+
+typedef struct
+{
+    // written by the producer only
+    struct
+    {
+        size_t in;      // total amount of bytes ever written
+        size_t outSeen; // last minimum of the active cursors
+    }
+    producer __attribute__((aligned(FifoDataport_CACHE_LINE_SIZE)));
+
+    FifoDataportBroadcast_Cursor cursor[FifoDataportBroadcast_MAX_CONSUMERS];
+
+    // set by joining consumers, cleared by the producer
+    struct
+    {
+        uint32_t joining;
+    }
+    requests __attribute__((aligned(FifoDataport_CACHE_LINE_SIZE)));
+
+    // written by the constructor only
+    struct
+    {
+        size_t capacity;
+        size_t consumers;
+        bool   evictLagging;
+    }
+    config __attribute__((aligned(FifoDataport_CACHE_LINE_SIZE)));
+
+    char data[] __attribute__((aligned(FifoDataport_CACHE_LINE_SIZE)));
+}
+FifoDataportBroadcast;
+
+
+//------------------------------------------------------------------------------
+/**
+ * @brief FifoDataportBroadcast constructor
+ *
+ * @param self (required) pointer to the FifoDataportBroadcast context
+ * @param capacity (required) capacity in bytes of the FIFO in the dataport,
+ *  must be a power of two
+ * @param consumers (required) number of consumers, at most
+ *  FifoDataportBroadcast_MAX_CONSUMERS
+ * @param evictLagging (required) true to evict consumers that are in the way
+ *  of a write instead of letting the write fail
+ *
+ * @retval true if succeeded
+ */
+static inline bool
+FifoDataportBroadcast_ctor(
+    FifoDataportBroadcast* self,
+    size_t capacity,
+    size_t consumers,
+    bool evictLagging)
+{
+    if ((NULL == self)
+        || (0 == capacity) || (0 != (capacity & (capacity - 1)))
+        || (0 == consumers)
+        || (consumers > FifoDataportBroadcast_MAX_CONSUMERS))
+    {
+        return false;
+    }
+
+    self->config.capacity = capacity;
+    self->config.consumers = consumers;
+    self->config.evictLagging = evictLagging;
+
+    for (size_t i = 0; i < consumers; i++)
+    {
+        self->cursor[i].out = 0;
+        self->cursor[i].inSeen = 0;
+        self->cursor[i].state = FifoDataportBroadcast_State_INACTIVE;
+    }
+    self->requests.joining = 0;
+
+    self->producer.outSeen = 0;
+    // Storing "in" last with release semantics makes the whole header visible
+    // to a consumer that already looks at the dataport.
+    FifoDataport_STORE_RELEASE(&self->producer.in, 0);
+
+    return true;
+}
+
+
+//------------------------------------------------------------------------------
+/**
+ * @brief returns the state of a consumer
+ *
+ * @param self (required) pointer to the FifoDataportBroadcast context
+ * @param id (required) index of the consumer
+ *
+ * @return the state of the consumer
+ */
+static inline FifoDataportBroadcast_State
+FifoDataportBroadcast_getState(
+    FifoDataportBroadcast* self,
+    size_t id)
+{
+    assert(id < self->config.consumers);
+    return (FifoDataportBroadcast_State)
+           FifoDataport_LOAD_ACQUIRE(&self->cursor[id].state);
+}
+
+
+//------------------------------------------------------------------------------
+/**
+ * @brief asks the producer to start sending data to a consumer, also used by
+ * an evicted consumer to get data again. To be called by the consumer.
+ *
+ * @param self (required) pointer to the FifoDataportBroadcast context
+ * @param id (required) index of the consumer
+ */
+static inline void
+FifoDataportBroadcast_join(
+    FifoDataportBroadcast* self,
+    size_t id)
+{
+    assert(id < self->config.consumers);
+
+    // The state is visible before the request, see
+    // FifoDataportBroadcast_handleJoins().
+    FifoDataport_STORE_RELEASE(&self->cursor[id].state,
+                               FifoDataportBroadcast_State_JOINING);
+    FifoDataport_STORE_RELEASE(&self->requests.joining, 1);
+}
+
+
+//------------------------------------------------------------------------------
+/**
+ * @brief stops sending data to a consumer. To be called by the consumer.
+ *
+ * @param self (required) pointer to the FifoDataportBroadcast context
+ * @param id (required) index of the consumer
+ */
+static inline void
+FifoDataportBroadcast_leave(
+    FifoDataportBroadcast* self,
+    size_t id)
+{
+    assert(id < self->config.consumers);
+
+    FifoDataport_STORE_RELEASE(&self->cursor[id].state,
+                               FifoDataportBroadcast_State_INACTIVE);
+}
+
+
+//------------------------------------------------------------------------------
+// Producer side only. Activates all joining consumers, they start at the
+// current "in", which is never less than the cached minimum of the cursors.
+static inline void
+FifoDataportBroadcast_handleJoins(
+    FifoDataportBroadcast* self)
+{
+    if (0 == FifoDataport_LOAD_RELAXED(&self->requests.joining))
+    {
+        return;
+    }
+    __atomic_exchange_n(&self->requests.joining, 0, __ATOMIC_ACQUIRE);
+
+    for (size_t i = 0; i < self->config.consumers; i++)
+    {
+        FifoDataportBroadcast_Cursor* cursor = &self->cursor[i];
+        uint32_t state = FifoDataportBroadcast_State_JOINING;
+
+        if (FifoDataport_LOAD_ACQUIRE(&cursor->state) == state)
+        {
+            cursor->out = self->producer.in;
+            cursor->inSeen = self->producer.in;
+            // fails if the consumer has left in the meantime
+            __atomic_compare_exchange_n(&cursor->state,
+                                        &state,
+                                        FifoDataportBroadcast_State_ACTIVE,
+                                        false,
+                                        __ATOMIC_RELEASE,
+                                        __ATOMIC_RELAXED);
+        }
+    }
+}
+
+
+//------------------------------------------------------------------------------
+// Producer side only. Returns the minimum "out" of all active consumers, which
+// is refreshed from the cursors only if the free space it leaves is less than
+// "wanted" bytes. If "evict" is set, consumers that are in the way of "wanted"
+// bytes are evicted if the FIFO has been created with "evictLagging".
+static inline size_t
+FifoDataportBroadcast_syncOut(
+    FifoDataportBroadcast* self,
+    size_t wanted,
+    bool evict)
+{
+    size_t capacity = self->config.capacity;
+    size_t in = self->producer.in;
+    size_t out = self->producer.outSeen;
+
+    if ((capacity - (in - out)) >= wanted)
+    {
+        return out;
+    }
+
+    bool evicted = false;
+    out = in;
+    for (size_t i = 0; i < self->config.consumers; i++)
+    {
+        FifoDataportBroadcast_Cursor* cursor = &self->cursor[i];
+        uint32_t state = FifoDataport_LOAD_ACQUIRE(&cursor->state);
+
+        if (FifoDataportBroadcast_State_ACTIVE != state)
+        {
+            continue;
+        }
+
+        size_t cursorOut = FifoDataport_LOAD_ACQUIRE(&cursor->out);
+        if (evict
+            && self->config.evictLagging
+            && ((capacity - (in - cursorOut)) < wanted)
+            && __atomic_compare_exchange_n(&cursor->state,
+                                           &state,
+                                           FifoDataportBroadcast_State_EVICTED,
+                                           false,
+                                           __ATOMIC_RELAXED,
+                                           __ATOMIC_RELAXED))
+        {
+            evicted = true;
+            continue;
+        }
+
+        if ((in - cursorOut) > (in - out))
+        {
+            out = cursorOut;
+        }
+    }
+
+    if (evicted)
+    {
+        // An evicted consumer may still be reading. The eviction must be
+        // visible before any data is overwritten, so the consumer can detect
+        // that it has read garbage, see FifoDataportBroadcast_read().
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+    }
+
+    self->producer.outSeen = out;
+    return out;
+}
+
+
+//------------------------------------------------------------------------------
+/**
+ * @brief returns the amount of bytes that could be still written, which is
+ * limited by the slowest active consumer. To be called by the producer.
+ *
+ * @param self (required) pointer to the FifoDataportBroadcast context
+ *
+ * @return amount of bytes that could be written
+ */
+static inline size_t
+FifoDataportBroadcast_getFree(
+    FifoDataportBroadcast* self)
+{
+    FifoDataportBroadcast_handleJoins(self);
+
+    // Just a query, it must not evict anyone.
+    size_t out = FifoDataportBroadcast_syncOut(self,
+                                               self->config.capacity,
+                                               false);
+    return self->config.capacity - (self->producer.in - out);
+}
+
+
+//------------------------------------------------------------------------------
+/**
+ * @brief copies a certain amount of bytes from a given buffer into the FIFO for
+ * all active consumers. To be called by the producer.
+ *
+ * @param self (required) pointer to the FifoDataportBroadcast context
+ * @param buf (required) pointer to the source buffer
+ * @param len (required) maximum amount of bytes that could be taken from buf
+ *
+ * @return the amount of bytes which have been actually copied, this is always
+ * len if the FIFO has been created with "evictLagging" and len is at most the
+ * capacity
+ */
+static inline size_t
+FifoDataportBroadcast_write(
+    FifoDataportBroadcast* self,
+    void const* buf,
+    size_t len)
+{
+    char const* source = buf;
+
+    if ((NULL == source) || (0 == len))
+    {
+        return 0;
+    }
+
+    FifoDataportBroadcast_handleJoins(self);
+
+    size_t capacity = self->config.capacity;
+    size_t in = self->producer.in;
+    size_t out = FifoDataportBroadcast_syncOut(self, len, true);
+    size_t free = capacity - (in - out);
+    size_t written = (len < free) ? len : free;
+
+    size_t index = in & (capacity - 1);
+    size_t chunk = capacity - index;
+    if (chunk > written)
+    {
+        chunk = written;
+    }
+    memcpy(&self->data[index], source, chunk);
+    memcpy(self->data, &source[chunk], written - chunk);
+
+    // Publish the data to the consumers only after it has been written.
+    FifoDataport_STORE_RELEASE(&self->producer.in, in + written);
+    return written;
+}
+
+
+//------------------------------------------------------------------------------
+/**
+ * @brief moves (copy and pop out) a certain amount of bytes from the FIFO to a
+ * given buffer for one consumer. To be called by the consumer.
+ *
+ * @param self (required) pointer to the FifoDataportBroadcast context
+ * @param id (required) index of the consumer
+ * @param buf (required) pointer to the destination buffer
+ * @param len (required) maximum amount of bytes that buf could take
+ *
+ * @return the amount of bytes which have been actually moved, 0 also if the
+ * consumer is not active, see FifoDataportBroadcast_getState()
+ */
+static inline size_t
+FifoDataportBroadcast_read(
+    FifoDataportBroadcast* self,
+    size_t id,
+    void* buf,
+    size_t len)
+{
+    assert(id < self->config.consumers);
+
+    FifoDataportBroadcast_Cursor* cursor = &self->cursor[id];
+    char* target = buf;
+
+    if ((NULL == target) || (0 == len)
+        || (FifoDataportBroadcast_getState(self, id)
+            != FifoDataportBroadcast_State_ACTIVE))
+    {
+        return 0;
+    }
+
+    size_t out = cursor->out;
+    size_t in = cursor->inSeen;
+    if ((in - out) < len)
+    {
+        in = FifoDataport_LOAD_ACQUIRE(&self->producer.in);
+        cursor->inSeen = in;
+    }
+
+    size_t capacity = self->config.capacity;
+    size_t read = ((in - out) < len) ? in - out : len;
+    size_t index = out & (capacity - 1);
+    size_t chunk = capacity - index;
+    if (chunk > read)
+    {
+        chunk = read;
+    }
+    memcpy(target, &self->data[index], chunk);
+    memcpy(&target[chunk], self->data, read - chunk);
+
+    // If we have been evicted while copying, the producer may have overwritten
+    // the data already. The fence pairs with the one in
+    // FifoDataportBroadcast_syncOut().
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (FifoDataport_LOAD_RELAXED(&cursor->state)
+        != FifoDataportBroadcast_State_ACTIVE)
+    {
+        return 0;
+    }
+
+    // Release the space to the producer only after we are done with the data.
+    FifoDataport_STORE_RELEASE(&cursor->out, out + read);
+    return read;
+}
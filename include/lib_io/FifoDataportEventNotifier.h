@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/**
+ * @addtogroup lib_io
+ * @{
+ *
+ * @file FifoDataportEventNotifier.h
+ *
+ * @brief a class that implements the FifoDataportNotifier.h interface with a
+ *  pair of wait/emit functions, e.g. those of a CAmkES event that is backed by
+ *  an seL4 notification object.
+ *
+ * @note seL4 notifications can't time out, so only waiting for ever (a timeout
+ *  of 0) is supported.
+ */
+
+#if !defined(FIFO_DATAPORT_EVENT_NOTIFIER_H)
+#define FIFO_DATAPORT_EVENT_NOTIFIER_H
+
+
+/* Includes ------------------------------------------------------------------*/
+
+#include "lib_io/FifoDataportNotifier.h"
+
+
+/* Exported macro ------------------------------------------------------------*/
+
+#define FifoDataportEventNotifier_TO_NOTIFIER(self) (&(self)->parent)
+
+
+/* Exported types ------------------------------------------------------------*/
+
+typedef void
+(*FifoDataportEventNotifier_EventT)(void);
+
+typedef struct FifoDataportEventNotifier FifoDataportEventNotifier;
+
+struct FifoDataportEventNotifier
+{
+    FifoDataportNotifier                parent;
+    FifoDataportEventNotifier_EventT    wait;
+    FifoDataportEventNotifier_EventT    emit;
+};
+
+
+/* Exported constants --------------------------------------------------------*/
+/* Exported functions ------------------------------------------------------- */
+/**
+ * @brief constructor
+ *
+ * @param self pointer to self
+ * @param wait function blocking until the event is emitted, can be NULL if
+ *  this side only signals
+ * @param emit function emitting the event to the other side, can be NULL if
+ *  this side only waits
+ *
+ * @return true if success
+ *
+ */
+bool
+FifoDataportEventNotifier_ctor(FifoDataportEventNotifier* self,
+                               FifoDataportEventNotifier_EventT wait,
+                               FifoDataportEventNotifier_EventT emit);
+/**
+ * @brief static implementation of virtual method FifoDataportNotifier_wait()
+ *
+ */
+bool
+FifoDataportEventNotifier_wait(FifoDataportNotifier* self,
+                               unsigned timeoutMs);
+/**
+ * @brief static implementation of virtual method FifoDataportNotifier_signal()
+ *
+ */
+void
+FifoDataportEventNotifier_signal(FifoDataportNotifier* self);
+/**
+ * @brief static implementation of virtual method FifoDataportNotifier_dtor()
+ *
+ */
+void
+FifoDataportEventNotifier_dtor(FifoDataportNotifier* self);
+
+#endif /* FIFO_DATAPORT_EVENT_NOTIFIER_H */
+///@}
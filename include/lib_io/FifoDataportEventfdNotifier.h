@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/**
+ * @addtogroup lib_io
+ * @{
+ *
+ * @file FifoDataportEventfdNotifier.h
+ *
+ * @brief a class that implements the FifoDataportNotifier.h interface with an
+ *  eventfd on Linux host builds.
+ *
+ * The side creating the notifier passes the file descriptor to the other
+ * side, which uses FifoDataportEventfdNotifier_ctorFromFd().
+ */
+
+#if !defined(FIFO_DATAPORT_EVENTFD_NOTIFIER_H)
+#define FIFO_DATAPORT_EVENTFD_NOTIFIER_H
+
+
+/* Includes ------------------------------------------------------------------*/
+
+#include "lib_io/FifoDataportNotifier.h"
+
+
+/* Exported macro ------------------------------------------------------------*/
+
+#define FifoDataportEventfdNotifier_TO_NOTIFIER(self) (&(self)->parent)
+
+
+/* Exported types ------------------------------------------------------------*/
+
+typedef struct FifoDataportEventfdNotifier FifoDataportEventfdNotifier;
+
+struct FifoDataportEventfdNotifier
+{
+    FifoDataportNotifier    parent;
+    int                     fd;
+};
+
+
+/* Exported constants --------------------------------------------------------*/
+/* Exported functions ------------------------------------------------------- */
+/**
+ * @brief constructor. Creates a new eventfd.
+ *
+ * @param self pointer to self
+ *
+ * @return true if success
+ *
+ */
+bool
+FifoDataportEventfdNotifier_ctor(FifoDataportEventfdNotifier* self);
+/**
+ * @brief constructor. Uses an eventfd created by the other side.
+ *
+ * @param self pointer to self
+ * @param fd file descriptor of the eventfd, it is duplicated so the caller
+ *  keeps ownership of the passed one
+ *
+ * @return true if success
+ *
+ */
+bool
+FifoDataportEventfdNotifier_ctorFromFd(FifoDataportEventfdNotifier* self,
+                                       int fd);
+/**
+ * @brief returns the file descriptor of the eventfd
+ *
+ */
+int
+FifoDataportEventfdNotifier_getFd(FifoDataportEventfdNotifier* self);
+/**
+ * @brief static implementation of virtual method FifoDataportNotifier_wait()
+ *
+ */
+bool
+FifoDataportEventfdNotifier_wait(FifoDataportNotifier* self,
+                                 unsigned timeoutMs);
+/**
+ * @brief static implementation of virtual method FifoDataportNotifier_signal()
+ *
+ */
+void
+FifoDataportEventfdNotifier_signal(FifoDataportNotifier* self);
+/**
+ * @brief static implementation of virtual method FifoDataportNotifier_dtor()
+ *
+ */
+void
+FifoDataportEventfdNotifier_dtor(FifoDataportNotifier* self);
+
+#endif /* FIFO_DATAPORT_EVENTFD_NOTIFIER_H */
+///@}
@@ -0,0 +1,213 @@
+/*
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/**
+ * @brief Lossy mode for a FifoDataport, where the producer overwrites the
+ * oldest data instead of waiting for the consumer.
+ * This is meant for data like telemetry, where fresh samples are worth more
+ * than old ones and the producer must stay within a fixed time bound. A write
+ * never fails and never waits for the consumer.
+ *
+ * If a write does not fit, the producer first moves "out" forward past the
+ * oldest bytes with a compare-and-swap and counts them as lost, then it writes
+ * its data. The consumer copies the data out and then moves "out" with a
+ * compare-and-swap, too. If this fails, the producer has moved "out" in the
+ * meantime and may have overwritten what was just copied, so the consumer
+ * discards the copy and retries from the new position. The amount of lost
+ * bytes is reported to the consumer by its next read at the latest.
+ *
+ * @note Producer and consumer of a lossy FifoDataport must only use the
+ * functions here for adding and removing data. If all writes have the same
+ * size and the capacity is a multiple of it, the lost bytes are always whole
+ * samples as long as the consumer reads whole samples, too.
+ *
+ */
+#pragma once
+
+#include "lib_io/FifoDataport.h"
+
+
+//------------------------------------------------------------------------------
+/**
+ * @brief copies a certain amount of bytes from a given buffer into the FIFO in
+ * the dataport, dropping the oldest bytes in the FIFO if there is not enough
+ * space. To be called by the producer.
+ *
+ * @note if len exceeds the capacity, only the last bytes of buf are written
+ * and the first ones are counted as lost
+ *
+ * @param self (required) pointer to the FifoDataport context
+ * @param buf (required) pointer to the source buffer
+ * @param len (required) amount of bytes to be taken from buf
+ */
+static inline void
+FifoDataport_writeLossy(
+    FifoDataport* self,
+    void const* buf,
+    size_t len)
+{
+    char const* source = buf;
+
+    if ((NULL == source) || (0 == len))
+    {
+        return;
+    }
+
+    size_t capacity = FifoDataport_getCapacity(self);
+    size_t in = self->producer.in;
+    size_t lost = 0;
+
+    if (len > capacity)
+    {
+        lost = len - capacity;
+        source += lost;
+        len = capacity;
+    }
+
+    // Failing only means the consumer has freed some space in the meantime,
+    // so this loop can't starve the producer.
+    size_t out = FifoDataport_LOAD_ACQUIRE(&self->consumer.out);
+    while ((capacity - (in - out)) < len)
+    {
+        size_t newOut = in + len - capacity;
+
+        // On success, the acquire semantics keep the data copy below from
+        // being done before "out" has moved, so a consumer that is still
+        // copying the old data will notice it with its own compare-and-swap.
+        if (__atomic_compare_exchange_n(&self->consumer.out,
+                                        &out,
+                                        newOut,
+                                        false,
+                                        __ATOMIC_ACQ_REL,
+                                        __ATOMIC_ACQUIRE))
+        {
+            lost += newOut - out;
+            break;
+        }
+    }
+
+    if (lost > 0)
+    {
+        __atomic_fetch_add(&self->producer.lost, lost, __ATOMIC_RELEASE);
+    }
+
+    FifoDataport_Segment segments[2];
+    FifoDataport_splitSegments(self,
+                               FifoDataport_toIndex(self, in),
+                               len,
+                               segments);
+    FifoDataport_copyIn(self, segments[0].buffer, source, segments[0].len);
+    if (segments[1].len > 0)
+    {
+        FifoDataport_copyIn(self, segments[1].buffer, &source[segments[0].len],
+                            segments[1].len);
+    }
+
+    self->producer.last = FifoDataport_advance(self, self->producer.last, len);
+    FifoDataport_statsAdded(self, len);
+    FifoDataport_latencyStamp(self, in + len);
+    // Publish the data to the consumer only after it has been written.
+    FifoDataport_STORE_RELEASE(&self->producer.in, in + len);
+}
+
+
+//------------------------------------------------------------------------------
+/**
+ * @brief moves (copy and pop out) a certain amount of bytes from the FIFO in
+ * the dataport to a given buffer. To be called by the consumer.
+ *
+ * @param self (required) pointer to the FifoDataport context
+ * @param buf (required) pointer to the destination buffer
+ * @param len (required) maximum amount of bytes that buf could take
+ * @param lost (optional) pointer to a variable that will be set to the amount
+ * of bytes dropped by the producer since the last call, it could be set to NULL
+ * by the caller if not interested in getting this information. The count is
+ * reset in any case.
+ *
+ * @return the amount of bytes which have been actually moved
+ */
+static inline size_t
+FifoDataport_readLossy(
+    FifoDataport* self,
+    void* buf,
+    size_t len,
+    size_t* lost)
+{
+    char* target = buf;
+    size_t capacity = FifoDataport_getCapacity(self);
+    size_t read = 0;
+
+    if ((NULL != target) && (len > 0))
+    {
+        size_t out = FifoDataport_LOAD_ACQUIRE(&self->consumer.out);
+
+        for (;;)
+        {
+            size_t in = FifoDataport_LOAD_ACQUIRE(&self->producer.in);
+            size_t used = in - out;
+
+            // The producer has moved "out" but not yet "in", our "out" is
+            // outdated.
+            if (used > capacity)
+            {
+                out = FifoDataport_LOAD_ACQUIRE(&self->consumer.out);
+                continue;
+            }
+
+            read = (used < len) ? used : len;
+            if (0 == read)
+            {
+                break;
+            }
+
+            FifoDataport_Segment segments[2];
+            FifoDataport_splitSegments(self,
+                                       FifoDataport_toIndex(self, out),
+                                       read,
+                                       segments);
+            memcpy(target, segments[0].buffer, segments[0].len);
+            if (segments[1].len > 0)
+            {
+                memcpy(&target[segments[0].len],
+                       segments[1].buffer,
+                       segments[1].len);
+            }
+
+            // The release semantics keep the data copy above from being done
+            // after "out" has moved. On failure, "out" is updated to the value
+            // set by the producer and we try again from there.
+            if (__atomic_compare_exchange_n(&self->consumer.out,
+                                            &out,
+                                            out + read,
+                                            false,
+                                            __ATOMIC_ACQ_REL,
+                                            __ATOMIC_ACQUIRE))
+            {
+                FifoDataport_statsRemoved(self, read);
+                FifoDataport_latencyTake(self, out + read);
+                break;
+            }
+        }
+    }
+
+    // "lost" is on the producer's cache line, so taking ownership of the line
+    // for the exchange is only worth it if something has been dropped.
+    size_t dropped = FifoDataport_LOAD_RELAXED(&self->producer.lost);
+    if (dropped > 0)
+    {
+        dropped = __atomic_exchange_n(&self->producer.lost,
+                                      0,
+                                      __ATOMIC_ACQUIRE);
+    }
+    if (lost)
+    {
+        *lost = dropped;
+    }
+
+    return read;
+}
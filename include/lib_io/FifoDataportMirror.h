@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/**
+ * @addtogroup lib_io
+ * @{
+ *
+ * @file FifoDataportMirror.h
+ *
+ * @brief allocator for a FifoDataport with a mirrored data area on Linux host
+ *  builds.
+ *
+ * The memory is a memfd whose data pages are mapped twice back-to-back, so
+ * the FifoDataport never has to stop at the buffer wrap around (see
+ * FifoDataport_ctorMirrored()). The memfd is organised in the following way:
+ *  __________________________________________________________________________
+ * | -------------------|-----------------------------------------------------|
+ * ||   FifoDataport    |                       data                         ||
+ * ||  (end of page 0)  |                 (page 1 .. page n)                 ||
+ * | -------------------|-----------------------------------------------------|
+ * |__________________________________________________________________________|
+ *
+ * and it is mapped as [page 0][page 1 .. page n][page 1 .. page n]. The side
+ * that creates the FifoDataport passes the file descriptor to the other side,
+ * which then maps it in the same way.
+ */
+
+#if !defined(FIFO_DATAPORT_MIRROR_H)
+#define FIFO_DATAPORT_MIRROR_H
+
+
+/* Includes ------------------------------------------------------------------*/
+
+#include "lib_io/FifoDataport.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+
+/* Exported macro ------------------------------------------------------------*/
+/* Exported types ------------------------------------------------------------*/
+
+typedef struct FifoDataportMirror FifoDataportMirror;
+
+struct FifoDataportMirror
+{
+    FifoDataport*   port;
+    void*           mapping;
+    size_t          mappingSize;
+    int             fd;
+};
+
+
+/* Exported constants --------------------------------------------------------*/
+/* Exported functions ------------------------------------------------------- */
+/**
+ * @brief constructor. Creates the memfd, maps it mirrored and constructs a
+ *  FifoDataport in it. This is supposed to be done by the producer.
+ *
+ * @param self pointer to self
+ * @param capacity minimum capacity of the FIFO in bytes, it is rounded up to a
+ *  multiple of the page size
+ *
+ * @return true if success
+ *
+ */
+bool
+FifoDataportMirror_ctor(FifoDataportMirror* self, size_t capacity);
+/**
+ * @brief constructor. Maps a memfd created by FifoDataportMirror_ctor() in
+ *  another process or thread and uses the FifoDataport that is already in it.
+ *
+ * @param self pointer to self
+ * @param fd file descriptor of the memfd, it is duplicated so the caller
+ *  keeps ownership of the passed one
+ *
+ * @return true if success
+ *
+ */
+bool
+FifoDataportMirror_ctorFromFd(FifoDataportMirror* self, int fd);
+/**
+ * @brief returns the file descriptor of the memfd that has to be passed to the
+ *  other side
+ *
+ */
+int
+FifoDataportMirror_getFd(FifoDataportMirror* self);
+/**
+ * @brief returns the FifoDataport in the mapping
+ *
+ */
+FifoDataport*
+FifoDataportMirror_getFifoDataport(FifoDataportMirror* self);
+/**
+ * @brief destructor. Unmaps the memory and closes the file descriptor.
+ *
+ */
+void
+FifoDataportMirror_dtor(FifoDataportMirror* self);
+
+#endif /* FIFO_DATAPORT_MIRROR_H */
+///@}
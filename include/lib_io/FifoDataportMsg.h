@@ -0,0 +1,359 @@
+/*
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/**
+ * @brief Length-prefixed messages in a FifoDataport.
+ * The producer reserves space for a message directly in the FIFO, writes the
+ * payload there and commits it with a single update of the FIFO indices. The
+ * consumer gets the whole message in place and releases it once it is done.
+ * So no intermediate buffers are needed on either side. Each message in the
+ * FIFO is organised in the following way:
+ *  __________________________________________________________________________
+ * | ------------|------------------------------------------------------------|
+ * || header     |               payload                | alignment padding  ||
+ * | ------------|------------------------------------------------------------|
+ * |__________________________________________________________________________|
+ *
+ * A message is never split at the buffer wrap around. If it does not fit into
+ * the space up to the end of the buffer, the producer fills that space with a
+ * padding record which the consumer skips, and places the message at the
+ * beginning of the buffer. Thus a message can be at most half of the capacity,
+ * unless the FifoDataport is mirrored (see FifoDataport_ctorMirrored()).
+ *
+ * As a consequence, FifoDataport_getContiguous() always covers whole records.
+ * A consumer can take all of them at once with FifoDataport_getMsgBatch(),
+ * hand each payload to a decoder in place and release the batch with a single
+ * update of the FIFO indices.
+ *
+ * @note A FifoDataport carrying messages must only be accessed with the
+ * functions here, its capacity must be a multiple of FifoDataport_MSG_ALIGN.
+ *
+ */
+#pragma once
+
+#include "lib_io/FifoDataport.h"
+
+#include <stdint.h>
+
+#define FifoDataport_MSG_ALIGN          8
+
+#define FifoDataport_MSG_FLAG_PADDING   (1u << 0)
+
+typedef struct
+{
+    uint32_t length;    // payload length, or whole record length for padding
+    uint32_t flags;
+}
+FifoDataport_MsgHeader;
+
+#define FifoDataport_MSG_RECORD_SIZE(_len_) \
+    ((sizeof(FifoDataport_MsgHeader) + (_len_) + FifoDataport_MSG_ALIGN - 1) \
+     & ~((size_t)FifoDataport_MSG_ALIGN - 1))
+
+
+//------------------------------------------------------------------------------
+/**
+ * @brief returns the maximum payload length of a message
+ *
+ * @param self (required) pointer to the FifoDataport context
+ *
+ * @return maximum payload length in bytes
+ */
+static inline size_t
+FifoDataport_getMaxMsgSize(
+    FifoDataport* self)
+{
+    size_t capacity = FifoDataport_getCapacity(self);
+    size_t space = self->config.mirrored ? capacity : capacity / 2;
+
+    space &= ~((size_t)FifoDataport_MSG_ALIGN - 1);
+    if (space < sizeof(FifoDataport_MsgHeader))
+    {
+        return 0;
+    }
+    space -= sizeof(FifoDataport_MsgHeader);
+
+    return (space > UINT32_MAX) ? UINT32_MAX : space;
+}
+
+
+//------------------------------------------------------------------------------
+/**
+ * @brief reserves space for a message in the FIFO in the dataport. The payload
+ * can be written to the returned buffer, the message becomes visible for the
+ * consumer with FifoDataport_commitMsg(). Calling this again before committing
+ * returns a new reservation.
+ *
+ * @param self (required) pointer to the FifoDataport context
+ * @param len (required) maximum payload length
+ *
+ * @return pointer to the payload buffer or NULL if there is not enough space
+ */
+static inline void*
+FifoDataport_reserveMsg(
+    FifoDataport* self,
+    size_t len)
+{
+    assert(0 == (FifoDataport_getCapacity(self) % FifoDataport_MSG_ALIGN));
+
+    if (len > FifoDataport_getMaxMsgSize(self))
+    {
+        Debug_LOG_ERROR("FifoDataport_reserveMsg() len %zu > max %zu",
+                        len, FifoDataport_getMaxMsgSize(self));
+        return NULL;
+    }
+
+    size_t record = FifoDataport_MSG_RECORD_SIZE(len);
+
+    void* buffer = NULL;
+    size_t contiguous = FifoDataport_getContiguousFreeCached(self, &buffer,
+                                                             record);
+    if (contiguous < record)
+    {
+        // If the free space runs up to the end of the buffer, the message may
+        // fit at the beginning of the buffer. Records are aligned, so there is
+        // always room for the padding header.
+        size_t capacity = FifoDataport_getCapacity(self);
+        size_t out = FifoDataport_syncOut(self, contiguous + record);
+        size_t free = capacity - (self->producer.in - out);
+        if ((0 == contiguous)
+            || ((char*)buffer + contiguous != &self->data[capacity])
+            || (free - contiguous < record))
+        {
+            return NULL;
+        }
+
+        FifoDataport_MsgHeader* padding = buffer;
+        padding->length = (uint32_t)contiguous;
+        padding->flags = FifoDataport_MSG_FLAG_PADDING;
+        buffer = self->data;
+    }
+
+    // The header is completed by FifoDataport_commitMsg(), until then it just
+    // marks this record as a message.
+    FifoDataport_MsgHeader* header = buffer;
+    header->length = (uint32_t)len;
+    header->flags = 0;
+
+    return &header[1];
+}
+
+
+//------------------------------------------------------------------------------
+/**
+ * @brief commits the message reserved with FifoDataport_reserveMsg(), so the
+ * consumer can get it
+ *
+ * @param self (required) pointer to the FifoDataport context
+ * @param len (required) actual payload length, at most the reserved length
+ */
+static inline void
+FifoDataport_commitMsg(
+    FifoDataport* self,
+    size_t len)
+{
+    // The reservation left either the message header or a padding header at
+    // the current position, nothing of this has been published yet.
+    FifoDataport_MsgHeader* header =
+        (FifoDataport_MsgHeader*)&self->data[self->producer.last];
+    size_t skip = 0;
+
+    if (header->flags & FifoDataport_MSG_FLAG_PADDING)
+    {
+        skip = header->length;
+        header = (FifoDataport_MsgHeader*)self->data;
+    }
+
+    assert(len <= header->length);
+    header->length = (uint32_t)len;
+
+    // Padding and message are published with one update.
+    FifoDataport_add(self, skip + FifoDataport_MSG_RECORD_SIZE(len));
+}
+
+
+//------------------------------------------------------------------------------
+/**
+ * @brief provides the next message in the FIFO in the dataport without
+ * removing it
+ *
+ * @param self (required) pointer to the FifoDataport context
+ * @param len (required) pointer to a variable that will be set to the payload
+ * length
+ *
+ * @return pointer to the payload or NULL if there is no message
+ */
+static inline void*
+FifoDataport_peekMsg(
+    FifoDataport* self,
+    size_t* len)
+{
+    void* buffer = NULL;
+    size_t contiguous = FifoDataport_getContiguous(self, &buffer);
+    if (0 == contiguous)
+    {
+        return NULL;
+    }
+
+    FifoDataport_MsgHeader* header = buffer;
+    if (header->flags & FifoDataport_MSG_FLAG_PADDING)
+    {
+        // The message following a padding record was published together with
+        // it, so it is there for sure.
+        FifoDataport_remove(self, header->length);
+        contiguous = FifoDataport_getContiguous(self, &buffer);
+        assert(contiguous >= sizeof(FifoDataport_MsgHeader));
+        header = buffer;
+    }
+
+    assert(contiguous >= FifoDataport_MSG_RECORD_SIZE(header->length));
+    *len = header->length;
+
+    return &header[1];
+}
+
+
+//------------------------------------------------------------------------------
+/**
+ * @brief removes the message provided by FifoDataport_peekMsg() from the FIFO
+ * in the dataport, its payload buffer must not be used anymore afterwards
+ *
+ * @param self (required) pointer to the FifoDataport context
+ */
+static inline void
+FifoDataport_releaseMsg(
+    FifoDataport* self)
+{
+    FifoDataport_MsgHeader* header =
+        (FifoDataport_MsgHeader*)&self->data[self->consumer.first];
+
+    assert(!(header->flags & FifoDataport_MSG_FLAG_PADDING));
+    FifoDataport_remove(self, FifoDataport_MSG_RECORD_SIZE(header->length));
+}
+
+
+//------------------------------------------------------------------------------
+/**
+ * @brief moves the next message from one FIFO in a dataport to another one,
+ * the payload is copied directly from src to dst. To be called by a component
+ * that is the consumer of src and the producer of dst.
+ *
+ * @param src (required) pointer to the FifoDataport context to consume from
+ * @param dst (required) pointer to the FifoDataport context to produce to
+ *
+ * @retval true if a message has been moved, false if there is no message in
+ * src or not enough space for it in dst
+ */
+static inline bool
+FifoDataport_relayMsg(
+    FifoDataport* src,
+    FifoDataport* dst)
+{
+    size_t len = 0;
+    void* payload = FifoDataport_peekMsg(src, &len);
+    if (NULL == payload)
+    {
+        return false;
+    }
+
+    void* target = FifoDataport_reserveMsg(dst, len);
+    if (NULL == target)
+    {
+        return false;
+    }
+
+    FifoDataport_copyIn(dst, target, payload, len);
+    FifoDataport_commitMsg(dst, len);
+    FifoDataport_releaseMsg(src);
+
+    return true;
+}
+
+
+//------------------------------------------------------------------------------
+/**
+ * @brief provides all messages in the FIFO in the dataport up to the buffer
+ * wrap around as one batch without removing them. Since messages never
+ * straddle the wrap around, the batch always consists of whole records, which
+ * can be walked with FifoDataport_nextMsg() and released at once with
+ * FifoDataport_releaseMsgBatch(). Messages behind the wrap around are in the
+ * next batch.
+ *
+ * @param self (required) pointer to the FifoDataport context
+ * @param batch (required) pointer to a pointer that will be set to the first
+ * record of the batch
+ *
+ * @return size of the batch in bytes, 0 if there is no message
+ */
+static inline size_t
+FifoDataport_getMsgBatch(
+    FifoDataport* self,
+    void** batch)
+{
+    return FifoDataport_getContiguous(self, batch);
+}
+
+
+//------------------------------------------------------------------------------
+/**
+ * @brief provides the next message in a batch returned by
+ * FifoDataport_getMsgBatch(), padding records are skipped
+ *
+ * @param batch (required) pointer to the batch
+ * @param size (required) size of the batch in bytes
+ * @param pos (required) pointer to the position in the batch, must be 0 for
+ * the first call and is advanced behind the message returned
+ * @param len (required) pointer to a variable that will be set to the payload
+ * length
+ *
+ * @return pointer to the payload or NULL at the end of the batch
+ */
+static inline void*
+FifoDataport_nextMsg(
+    void* batch,
+    size_t size,
+    size_t* pos,
+    size_t* len)
+{
+    while (*pos < size)
+    {
+        FifoDataport_MsgHeader* header =
+            (FifoDataport_MsgHeader*)((char*)batch + *pos);
+
+        if (header->flags & FifoDataport_MSG_FLAG_PADDING)
+        {
+            *pos += header->length;
+            continue;
+        }
+
+        assert(size - *pos >= FifoDataport_MSG_RECORD_SIZE(header->length));
+        *pos += FifoDataport_MSG_RECORD_SIZE(header->length);
+        *len = header->length;
+        return &header[1];
+    }
+
+    return NULL;
+}
+
+
+//------------------------------------------------------------------------------
+/**
+ * @brief removes a batch provided by FifoDataport_getMsgBatch() from the FIFO
+ * in the dataport with a single index update, the payload buffers of its
+ * messages must not be used anymore afterwards
+ *
+ * @param self (required) pointer to the FifoDataport context
+ * @param size (required) size of the batch in bytes
+ */
+static inline void
+FifoDataport_releaseMsgBatch(
+    FifoDataport* self,
+    size_t size)
+{
+    FifoDataport_remove(self, size);
+}
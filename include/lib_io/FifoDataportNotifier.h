@@ -0,0 +1,437 @@
+/*
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/**
+ * @addtogroup lib_io
+ * @{
+ *
+ * @file FifoDataportNotifier.h
+ *
+ * @brief interface that abstracts a notification primitive to block on a
+ *  FifoDataport, and the blocking wait functions using it.
+ *
+ * A notifier is a counting or binary signal, so a signal that is raised before
+ * the other side blocks on it is not lost. For each direction of a
+ * FifoDataport one notifier is needed: the producer signals the consumer's
+ * notifier after FifoDataport_add() and the consumer signals the producer's
+ * notifier after FifoDataport_remove().
+ *
+ * Signalling after every operation floods the other side with wakeups under
+ * load. FifoDataport_addAndNotify(), FifoDataport_removeAndNotify() and their
+ * read/write variants act as a doorbell instead: the producer signals only if
+ * the FIFO has been empty or the consumer has announced that it is about to
+ * block, the consumer signals only if the producer has announced that it is
+ * about to block and the free space has reached the low-water mark (see
+ * FifoDataport_setLowWater()). The announcement is a flag in the FifoDataport
+ * that the blocking side sets before it checks the FIFO a last time. The side
+ * that signals clears it, so a sleeper is woken once.
+ *
+ * The wait functions first spin on the FifoDataport with a CPU pause hint and
+ * then block on the notifier. The spin time adapts itself: it grows as long as
+ * waits end while spinning and shrinks when a wait has to block.
+ */
+
+#if !defined(FIFO_DATAPORT_NOTIFIER_H)
+#define FIFO_DATAPORT_NOTIFIER_H
+
+/* Includes ------------------------------------------------------------------*/
+
+#include "lib_compiler/compiler.h"
+
+#include "lib_debug/Debug.h"
+
+#include "lib_io/FifoDataport.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+
+/* Exported macro ------------------------------------------------------------*/
+
+#define FifoDataportNotifier_SPIN_MIN       16
+#define FifoDataportNotifier_SPIN_DEFAULT   1024
+#define FifoDataportNotifier_SPIN_MAX       (64 * 1024)
+
+
+/* Exported types ------------------------------------------------------------*/
+
+typedef struct FifoDataportNotifier FifoDataportNotifier;
+
+typedef bool
+(*FifoDataportNotifier_WaitT)(FifoDataportNotifier* self,
+                              unsigned timeoutMs);
+
+typedef void
+(*FifoDataportNotifier_SignalT)(FifoDataportNotifier* self);
+
+typedef void
+(*FifoDataportNotifier_DtorT)(FifoDataportNotifier* self);
+
+typedef struct
+{
+    FifoDataportNotifier_WaitT      wait;
+    FifoDataportNotifier_SignalT    signal;
+    FifoDataportNotifier_DtorT      dtor;
+}
+FifoDataportNotifier_Vtable;
+
+struct FifoDataportNotifier
+{
+    const FifoDataportNotifier_Vtable* vtable;
+    unsigned spinLimit;
+};
+
+typedef bool
+(*FifoDataportNotifier_CondT)(FifoDataport* port, size_t amount);
+
+
+/* Exported constants --------------------------------------------------------*/
+/* Exported dynamic functions ----------------------------------------------- */
+
+/**
+ * @brief blocks until the notifier is signaled or the timeout expires. A
+ *  pending signal is consumed and makes it return immediately.
+ *
+ * @param self pointer to self
+ * @param timeoutMs timeout in milliseconds, can be 0 to wait for ever
+ *
+ * @return true if signaled, false on timeout
+ *
+ */
+INLINE bool
+FifoDataportNotifier_wait(FifoDataportNotifier* self, unsigned timeoutMs)
+{
+    Debug_ASSERT_SELF(self);
+    return self->vtable->wait(self, timeoutMs);
+}
+/**
+ * @brief signals the notifier, wakes up the side blocked on it or makes its
+ *  next wait return immediately
+ *
+ * @param self pointer to self
+ *
+ */
+INLINE void
+FifoDataportNotifier_signal(FifoDataportNotifier* self)
+{
+    Debug_ASSERT_SELF(self);
+    self->vtable->signal(self);
+}
+/**
+ * @brief destructor
+ *
+ * @param self pointer to self
+ *
+ */
+INLINE void
+FifoDataportNotifier_dtor(FifoDataportNotifier* self)
+{
+    Debug_ASSERT_SELF(self);
+    self->vtable->dtor(self);
+}
+
+/* Exported static functions ------------------------------------------------ */
+
+/**
+ * @brief to be called by the constructors of the implementations
+ *
+ */
+INLINE void
+FifoDataportNotifier_init(FifoDataportNotifier* self,
+                          const FifoDataportNotifier_Vtable* vtable)
+{
+    Debug_ASSERT_SELF(self);
+
+    self->vtable    = vtable;
+    self->spinLimit = FifoDataportNotifier_SPIN_DEFAULT;
+}
+/**
+ * @brief spins and then blocks on the notifier until cond() is true for the
+ *  FifoDataport. The timeout applies to each blocking wait, so a signal left
+ *  over from earlier calls can extend the total time up to twice the timeout.
+ *  Before blocking, the flag 'sleeping' in the FifoDataport is set, so the
+ *  other side knows it has to signal.
+ *
+ * @return true if cond() is true, false on timeout
+ *
+ */
+INLINE bool
+FifoDataportNotifier_waitFor(FifoDataportNotifier* self,
+                             FifoDataport* port,
+                             size_t amount,
+                             FifoDataportNotifier_CondT cond,
+                             size_t* sleeping,
+                             unsigned timeoutMs)
+{
+    Debug_ASSERT_SELF(self);
+
+    for (unsigned i = 0; i < self->spinLimit; i++)
+    {
+        if (cond(port, amount))
+        {
+            if (self->spinLimit < FifoDataportNotifier_SPIN_MAX)
+            {
+                self->spinLimit *= 2;
+            }
+            return true;
+        }
+        FifoDataport_CPU_RELAX();
+    }
+
+    if (self->spinLimit > FifoDataportNotifier_SPIN_MIN)
+    {
+        self->spinLimit /= 2;
+    }
+
+    bool isMet = false;
+    for (;;)
+    {
+        // Pairs with the barrier in FifoDataportNotifier_wakeConsumer() and
+        // FifoDataportNotifier_wakeProducer(): either the other side sees our
+        // flag and signals, or we see its update of the FIFO here.
+        __atomic_store_n(sleeping, 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if (cond(port, amount))
+        {
+            isMet = true;
+            break;
+        }
+        if (!FifoDataportNotifier_wait(self, timeoutMs))
+        {
+            isMet = cond(port, amount);
+            break;
+        }
+    }
+    __atomic_store_n(sleeping, 0, __ATOMIC_RELAXED);
+
+    return isMet;
+}
+
+// Consumer side condition for FifoDataport_waitData().
+INLINE bool
+FifoDataportNotifier_hasData(FifoDataport* port, size_t amount)
+{
+    return (FifoDataport_syncIn(port, amount) - port->consumer.out) >= amount;
+}
+
+// Producer side condition for FifoDataport_waitSpace().
+INLINE bool
+FifoDataportNotifier_hasSpace(FifoDataport* port, size_t amount)
+{
+    size_t capacity = FifoDataport_getCapacity(port);
+    size_t out = FifoDataport_syncOut(port, amount);
+
+    return (capacity - (port->producer.in - out)) >= amount;
+}
+/**
+ * @brief blocks the consumer until there is data in the FifoDataport. The
+ *  producer must signal the notifier after adding data, at least when done
+ *  by FifoDataport_addAndNotify().
+ *
+ * @param self pointer to the FifoDataport
+ * @param notifier notifier the producer signals
+ * @param timeoutMs timeout in milliseconds, can be 0 to wait for ever
+ *
+ * @return true if there is data, false on timeout
+ *
+ */
+INLINE bool
+FifoDataport_waitData(FifoDataport* self,
+                      FifoDataportNotifier* notifier,
+                      unsigned timeoutMs)
+{
+    return FifoDataportNotifier_waitFor(notifier, self, 1,
+                                        FifoDataportNotifier_hasData,
+                                        &self->consumer.sleeping,
+                                        timeoutMs);
+}
+/**
+ * @brief blocks the producer until there is room for 'amount' bytes in the
+ *  FifoDataport. The consumer must signal the notifier after removing data,
+ *  at least when done by FifoDataport_removeAndNotify().
+ *
+ * @param self pointer to the FifoDataport
+ * @param notifier notifier the consumer signals
+ * @param amount amount of bytes that must fit, at most the capacity
+ * @param timeoutMs timeout in milliseconds, can be 0 to wait for ever
+ *
+ * @return true if there is room, false on timeout
+ *
+ */
+INLINE bool
+FifoDataport_waitSpace(FifoDataport* self,
+                       FifoDataportNotifier* notifier,
+                       size_t amount,
+                       unsigned timeoutMs)
+{
+    if (amount > FifoDataport_getCapacity(self))
+    {
+        Debug_LOG_ERROR("amount %zu exceeds capacity %zu",
+                        amount, FifoDataport_getCapacity(self));
+        return false;
+    }
+    return FifoDataportNotifier_waitFor(notifier, self, amount,
+                                        FifoDataportNotifier_hasSpace,
+                                        &self->producer.sleeping,
+                                        timeoutMs);
+}
+
+// Takes the flag 'sleeping' set by the other side, so only one signal is sent
+// for each time it blocks.
+INLINE bool
+FifoDataportNotifier_takeSleeping(size_t* sleeping)
+{
+    size_t expected = 1;
+
+    return (0 != FifoDataport_LOAD_RELAXED(sleeping))
+           && __atomic_compare_exchange_n(sleeping, &expected, 0, false,
+                                          __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+}
+/**
+ * @brief producer side doorbell, signals the consumer if the FifoDataport has
+ *  been empty before 'in' was moved on from 'inBefore' or if the consumer is
+ *  about to block. To be called after the data has been added.
+ *
+ */
+INLINE void
+FifoDataportNotifier_wakeConsumer(FifoDataportNotifier* self,
+                                  FifoDataport* port,
+                                  size_t inBefore)
+{
+    Debug_ASSERT_SELF(self);
+
+    // Pairs with the barrier in FifoDataportNotifier_waitFor().
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    bool wasEmpty = (FifoDataport_LOAD_RELAXED(&port->consumer.out) == inBefore);
+    if (FifoDataportNotifier_takeSleeping(&port->consumer.sleeping) || wasEmpty)
+    {
+        FifoDataportNotifier_signal(self);
+    }
+}
+/**
+ * @brief consumer side doorbell, signals the producer if it is about to block
+ *  and the free space has reached the low-water mark. To be called after the
+ *  data has been removed.
+ *
+ */
+INLINE void
+FifoDataportNotifier_wakeProducer(FifoDataportNotifier* self,
+                                  FifoDataport* port)
+{
+    Debug_ASSERT_SELF(self);
+
+    // Pairs with the barrier in FifoDataportNotifier_waitFor().
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    if (0 == FifoDataport_LOAD_RELAXED(&port->producer.sleeping))
+    {
+        return;
+    }
+
+    size_t capacity = FifoDataport_getCapacity(port);
+    size_t used = FifoDataport_LOAD_ACQUIRE(&port->producer.in)
+                  - port->consumer.out;
+    if ((capacity - used) < FifoDataport_LOAD_RELAXED(&port->config.lowWater))
+    {
+        return;
+    }
+
+    if (FifoDataportNotifier_takeSleeping(&port->producer.sleeping))
+    {
+        FifoDataportNotifier_signal(self);
+    }
+}
+/**
+ * @brief FifoDataport_add() followed by the producer side doorbell
+ *
+ * @param self pointer to the FifoDataport
+ * @param amount amount pushed
+ * @param notifier notifier the consumer waits on
+ *
+ */
+INLINE void
+FifoDataport_addAndNotify(FifoDataport* self,
+                          size_t amount,
+                          FifoDataportNotifier* notifier)
+{
+    size_t in = self->producer.in;
+
+    FifoDataport_add(self, amount);
+    FifoDataportNotifier_wakeConsumer(notifier, self, in);
+}
+/**
+ * @brief FifoDataport_remove() followed by the consumer side doorbell
+ *
+ * @param self pointer to the FifoDataport
+ * @param amount amount to be removed
+ * @param notifier notifier the producer waits on
+ *
+ */
+INLINE void
+FifoDataport_removeAndNotify(FifoDataport* self,
+                             size_t amount,
+                             FifoDataportNotifier* notifier)
+{
+    FifoDataport_remove(self, amount);
+    FifoDataportNotifier_wakeProducer(notifier, self);
+}
+/**
+ * @brief FifoDataport_write() followed by the producer side doorbell
+ *
+ * @param self pointer to the FifoDataport
+ * @param buf pointer to the source buffer
+ * @param len maximum amount of bytes that could be taken from buf
+ * @param notifier notifier the consumer waits on
+ *
+ * @return the amount of bytes which have been actually copied
+ *
+ */
+INLINE size_t
+FifoDataport_writeAndNotify(FifoDataport* self,
+                            void const* buf,
+                            size_t len,
+                            FifoDataportNotifier* notifier)
+{
+    size_t in = self->producer.in;
+    size_t written = FifoDataport_write(self, buf, len);
+
+    if (written > 0)
+    {
+        FifoDataportNotifier_wakeConsumer(notifier, self, in);
+    }
+    return written;
+}
+/**
+ * @brief FifoDataport_read() followed by the consumer side doorbell
+ *
+ * @param self pointer to the FifoDataport
+ * @param buf pointer to the destination buffer
+ * @param len maximum amount of bytes that buf could take
+ * @param notifier notifier the producer waits on
+ *
+ * @return the amount of bytes which have been actually moved
+ *
+ */
+INLINE size_t
+FifoDataport_readAndNotify(FifoDataport* self,
+                           void* buf,
+                           size_t len,
+                           FifoDataportNotifier* notifier)
+{
+    size_t read = FifoDataport_read(self, buf, len);
+
+    if (read > 0)
+    {
+        FifoDataportNotifier_wakeProducer(notifier, self);
+    }
+    return read;
+}
+
+#endif /* FIFO_DATAPORT_NOTIFIER_H */
+///@}
@@ -0,0 +1,279 @@
+/*
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/**
+ * @brief Descriptor rings with a shared buffer pool in a dataport.
+ * Large payloads are not copied through a FIFO. The producer takes a buffer
+ * from a pool in the dataport, fills it in place and passes only a descriptor
+ * with the buffer's offset and the payload length to the consumer. The
+ * consumer uses the payload in place and hands the buffer back through a
+ * return ring. The dataport is organised in the following way:
+ *  __________________________________________________________________________
+ * | -------------|-------------|--------|------------------------------------|
+ * || submit ring | return ring | config |   buffers[buffers][bufferSize]    ||
+ * | -------------|-------------|--------|------------------------------------|
+ * |__________________________________________________________________________|
+ *
+ * Both rings are typed FIFOs of descriptors, see FifoDataportT.h. A buffer is
+ * always in exactly one of the rings or in use by one side, and the rings can
+ * take all buffers, so pushing to them never fails. The return ring also
+ * serves as the producer's list of free buffers: the constructor puts all
+ * buffers there.
+ *
+ * @note The pool is supposed to be created by the Producer. Descriptors coming
+ * from the other side are checked before they are used.
+ *
+ */
+#pragma once
+
+#include "lib_io/FifoDataport.h"
+#include "lib_io/FifoDataportT.h"
+
+#include <stdint.h>
+
+// Maximum number of buffers in a pool, must be a power of two. It changes the
+// layout of the dataport, so all components sharing a dataport must use the
+// same setting.
+#if !defined(FifoDataportPool_MAX_BUFFERS)
+#define FifoDataportPool_MAX_BUFFERS    64
+#endif
+
+typedef struct
+{
+    uint32_t offset;    // offset of the buffer in the data area of the pool
+    uint32_t len;       // payload length
+}
+FifoDataportPool_Desc;
+
+FifoDataportT_DECLARE(FifoDataportPool_Desc,
+                      FifoDataportPool_Ring,
+                      FifoDataportPool_MAX_BUFFERS)
+
+typedef struct
+{
+    FifoDataportPool_Ring submit;   // filled buffers, producer to consumer
+    FifoDataportPool_Ring release;  // used buffers, consumer to producer
+
+    // written by the constructor only
+    struct
+    {
+        size_t bufferSize;
+        size_t buffers;
+    }
+    config __attribute__((aligned(FifoDataport_CACHE_LINE_SIZE)));
+
+    char data[] __attribute__((aligned(FifoDataport_CACHE_LINE_SIZE)));
+}
+FifoDataportPool;
+
+// Size of a dataport holding a pool.
+#define FifoDataportPool_SIZE(_bufferSize_, _buffers_) \
+    (sizeof(FifoDataportPool) + ((size_t)(_bufferSize_) * (_buffers_)))
+
+
+//------------------------------------------------------------------------------
+/**
+ * @brief FifoDataportPool constructor, all buffers are free afterwards
+ *
+ * @param self (required) pointer to the FifoDataportPool context
+ * @param bufferSize (required) size of each buffer in bytes, must be a
+ * multiple of FifoDataport_CACHE_LINE_SIZE
+ * @param buffers (required) number of buffers, at most
+ * FifoDataportPool_MAX_BUFFERS. The dataport must be at least
+ * FifoDataportPool_SIZE(bufferSize, buffers) bytes
+ *
+ * @retval true if succeeded
+ */
+static inline bool
+FifoDataportPool_ctor(
+    FifoDataportPool* self,
+    size_t bufferSize,
+    size_t buffers)
+{
+    if ((NULL == self) || (0 == bufferSize) || (0 == buffers))
+    {
+        return false;
+    }
+    if ((0 != (bufferSize % FifoDataport_CACHE_LINE_SIZE))
+        || (buffers > FifoDataportPool_MAX_BUFFERS)
+        || ((bufferSize * buffers) > UINT32_MAX))
+    {
+        Debug_LOG_ERROR("FifoDataportPool %zu buffers of %zu bytes not possible",
+                        buffers, bufferSize);
+        return false;
+    }
+
+    self->config.bufferSize = bufferSize;
+    self->config.buffers = buffers;
+
+    FifoDataportPool_Ring_ctor(&self->submit);
+    FifoDataportPool_Ring_ctor(&self->release);
+
+    for (size_t i = 0; i < buffers; i++)
+    {
+        FifoDataportPool_Desc desc = { .offset = (uint32_t)(i * bufferSize) };
+        FifoDataportPool_Ring_push(&self->release, &desc);
+    }
+
+    return true;
+}
+
+
+//------------------------------------------------------------------------------
+/**
+ * @brief returns the size of the buffers
+ *
+ * @param self (required) pointer to the FifoDataportPool context
+ *
+ * @return size of a buffer in bytes
+ */
+static inline size_t
+FifoDataportPool_getBufferSize(
+    FifoDataportPool* self)
+{
+    return self->config.bufferSize;
+}
+
+
+//------------------------------------------------------------------------------
+/**
+ * @brief returns the buffer a descriptor refers to, after checking the
+ * descriptor. Can be called by both sides.
+ *
+ * @param self (required) pointer to the FifoDataportPool context
+ * @param desc (required) pointer to the descriptor
+ *
+ * @return pointer to the buffer or NULL if the descriptor is invalid
+ */
+static inline void*
+FifoDataportPool_getBuffer(
+    FifoDataportPool* self,
+    FifoDataportPool_Desc const* desc)
+{
+    size_t bufferSize = self->config.bufferSize;
+
+    if ((desc->offset % bufferSize != 0)
+        || (desc->offset / bufferSize >= self->config.buffers)
+        || (desc->len > bufferSize))
+    {
+        Debug_LOG_ERROR("FifoDataportPool invalid descriptor %u/%u",
+                        desc->offset, desc->len);
+        return NULL;
+    }
+
+    return &self->data[desc->offset];
+}
+
+
+//------------------------------------------------------------------------------
+/**
+ * @brief takes a free buffer from the pool. To be called by the producer.
+ *
+ * @param self (required) pointer to the FifoDataportPool context
+ * @param desc (required) pointer to a descriptor that will be set to the
+ * buffer, its length to the buffer size
+ *
+ * @return pointer to the buffer or NULL if there is no free buffer
+ */
+static inline void*
+FifoDataportPool_acquire(
+    FifoDataportPool* self,
+    FifoDataportPool_Desc* desc)
+{
+    while (FifoDataportPool_Ring_pop(&self->release, desc))
+    {
+        desc->len = (uint32_t)self->config.bufferSize;
+        void* buffer = FifoDataportPool_getBuffer(self, desc);
+        if (NULL != buffer)
+        {
+            return buffer;
+        }
+        // An invalid descriptor is dropped, its buffer is lost.
+    }
+
+    return NULL;
+}
+
+
+//------------------------------------------------------------------------------
+/**
+ * @brief passes a filled buffer to the consumer, the buffer must not be used
+ * anymore afterwards. To be called by the producer.
+ *
+ * @param self (required) pointer to the FifoDataportPool context
+ * @param desc (required) pointer to the descriptor returned by
+ * FifoDataportPool_acquire()
+ * @param len (required) payload length, at most the buffer size
+ */
+static inline void
+FifoDataportPool_submit(
+    FifoDataportPool* self,
+    FifoDataportPool_Desc const* desc,
+    size_t len)
+{
+    assert(len <= self->config.bufferSize);
+
+    FifoDataportPool_Desc submitted = { .offset = desc->offset,
+                                        .len = (uint32_t)len };
+
+    // There is room for all buffers in the ring.
+    bool isPushed = FifoDataportPool_Ring_push(&self->submit, &submitted);
+    assert(isPushed);
+    (void)isPushed;
+}
+
+
+//------------------------------------------------------------------------------
+/**
+ * @brief takes the next filled buffer from the producer. To be called by the
+ * consumer.
+ *
+ * @param self (required) pointer to the FifoDataportPool context
+ * @param desc (required) pointer to a descriptor that will be set to the
+ * buffer and the payload length
+ *
+ * @return pointer to the payload or NULL if there is no filled buffer
+ */
+static inline void*
+FifoDataportPool_receive(
+    FifoDataportPool* self,
+    FifoDataportPool_Desc* desc)
+{
+    while (FifoDataportPool_Ring_pop(&self->submit, desc))
+    {
+        void* buffer = FifoDataportPool_getBuffer(self, desc);
+        if (NULL != buffer)
+        {
+            return buffer;
+        }
+        // An invalid descriptor is dropped, its buffer is lost.
+    }
+
+    return NULL;
+}
+
+
+//------------------------------------------------------------------------------
+/**
+ * @brief hands a buffer back to the producer, the buffer must not be used
+ * anymore afterwards. To be called by the consumer.
+ *
+ * @param self (required) pointer to the FifoDataportPool context
+ * @param desc (required) pointer to the descriptor returned by
+ * FifoDataportPool_receive()
+ */
+static inline void
+FifoDataportPool_release(
+    FifoDataportPool* self,
+    FifoDataportPool_Desc const* desc)
+{
+    // There is room for all buffers in the ring.
+    bool isPushed = FifoDataportPool_Ring_push(&self->release, desc);
+    assert(isPushed);
+    (void)isPushed;
+}
@@ -0,0 +1,310 @@
+/*
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/**
+ * @brief Readiness set for a consumer serving many FifoDataports.
+ * Instead of polling every FifoDataport, the consumer gets the ids of the
+ * ports that have data, so idle ports cost nothing. The set is a bitmap with
+ * one bit per port id, placed in memory shared with all producers, e.g. a
+ * dataport of its own.
+ *
+ * A producer sets the bit of its port when the port goes from empty to not
+ * empty, see FifoDataportReadySet_add(). The consumer takes all set bits at
+ * once with FifoDataportReadySet_collect() and clears them in the same step.
+ * After serving a port, whether it has been drained or not, the consumer
+ * calls FifoDataportReadySet_rearm(), which sets the bit again if there is
+ * still data. Both sides use a full barrier between updating their own index
+ * and checking the other's, so either the producer sees the port empty and
+ * sets the bit, or the consumer sees the new data when rearming. Data can
+ * thus never be left in a port without its bit set.
+ *
+ * @note The consumer is the only one to clear bits, any number of producers
+ * can set them.
+ *
+ */
+#pragma once
+
+#include "lib_io/FifoDataport.h"
+#include "lib_io/FifoDataportNotifier.h"
+
+#include <stdint.h>
+
+#if !defined(FifoDataportReadySet_MAX_PORTS)
+#define FifoDataportReadySet_MAX_PORTS  64
+#endif
+
+#define FifoDataportReadySet_WORDS \
+    ((FifoDataportReadySet_MAX_PORTS + 63) / 64)
+
+typedef struct
+{
+    uint64_t ready[FifoDataportReadySet_WORDS];
+}
+__attribute__((aligned(FifoDataport_CACHE_LINE_SIZE)))
+FifoDataportReadySet;
+
+
+//------------------------------------------------------------------------------
+/**
+ * @brief FifoDataportReadySet constructor, no port is ready afterwards
+ *
+ * @param self (required) pointer to the FifoDataportReadySet context
+ *
+ * @retval true if succeeded
+ */
+static inline bool
+FifoDataportReadySet_ctor(
+    FifoDataportReadySet* self)
+{
+    if (NULL == self)
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < FifoDataportReadySet_WORDS; i++)
+    {
+        __atomic_store_n(&self->ready[i], 0, __ATOMIC_RELEASE);
+    }
+
+    return true;
+}
+
+
+//------------------------------------------------------------------------------
+/**
+ * @brief marks a port as ready
+ *
+ * @param self (required) pointer to the FifoDataportReadySet context
+ * @param id (required) id of the port
+ */
+static inline void
+FifoDataportReadySet_mark(
+    FifoDataportReadySet* self,
+    size_t id)
+{
+    assert(id < FifoDataportReadySet_MAX_PORTS);
+
+    __atomic_fetch_or(&self->ready[id / 64],
+                      (uint64_t)1 << (id % 64),
+                      __ATOMIC_RELEASE);
+}
+
+
+//------------------------------------------------------------------------------
+/**
+ * @brief counts as pushed a certain amount of bytes in a FifoDataport like
+ * FifoDataport_add() does, and marks the port as ready if it has been empty.
+ * To be called by the producer of the port.
+ *
+ * @param self (required) pointer to the FifoDataportReadySet context
+ * @param id (required) id of the port
+ * @param port (required) pointer to the FifoDataport context
+ * @param amount (required) amount pushed
+ *
+ * @retval true if the port has been marked, a consumer blocked in
+ * FifoDataportReadySet_wait() must be signalled then
+ */
+static inline bool
+FifoDataportReadySet_add(
+    FifoDataportReadySet* self,
+    size_t id,
+    FifoDataport* port,
+    size_t amount)
+{
+    size_t in = port->producer.in;
+
+    FifoDataport_add(port, amount);
+
+    // Pairs with the barrier in FifoDataportReadySet_rearm(): if the consumer
+    // has not seen our new "in", we see its final "out" here.
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (FifoDataport_LOAD_RELAXED(&port->consumer.out) != in)
+    {
+        // The consumer has not drained the port yet, it will rearm it.
+        return false;
+    }
+
+    FifoDataportReadySet_mark(self, id);
+    return true;
+}
+
+
+//------------------------------------------------------------------------------
+/**
+ * @brief copies bytes into a FifoDataport like FifoDataport_write() does, and
+ * marks the port as ready if it has been empty. To be called by the producer
+ * of the port.
+ *
+ * @param self (required) pointer to the FifoDataportReadySet context
+ * @param id (required) id of the port
+ * @param port (required) pointer to the FifoDataport context
+ * @param buf (required) pointer to the source buffer
+ * @param len (required) maximum amount of bytes that could be taken from buf
+ * @param marked (optional) pointer to a variable that will be set to true if
+ * the port has been marked, see FifoDataportReadySet_add()
+ *
+ * @return the amount of bytes which have been actually copied
+ */
+static inline size_t
+FifoDataportReadySet_write(
+    FifoDataportReadySet* self,
+    size_t id,
+    FifoDataport* port,
+    void const* buf,
+    size_t len,
+    bool* marked)
+{
+    char const* source = buf;
+    FifoDataport_Segment segments[2];
+    size_t written = 0;
+
+    if ((NULL != source) && (len > 0))
+    {
+        FifoDataport_getSegmentsFreeCached(port, segments, len);
+
+        for (size_t i = 0; (i < 2) && (written < len); i++)
+        {
+            size_t chunk = len - written;
+            if (chunk > segments[i].len)
+            {
+                chunk = segments[i].len;
+            }
+            if (0 == chunk)
+            {
+                break;
+            }
+            FifoDataport_copyIn(port, segments[i].buffer, &source[written],
+                                chunk);
+            written += chunk;
+        }
+    }
+
+    bool isMarked = (written > 0)
+                    && FifoDataportReadySet_add(self, id, port, written);
+    if (marked)
+    {
+        *marked = isMarked;
+    }
+    return written;
+}
+
+
+//------------------------------------------------------------------------------
+/**
+ * @brief marks a port as ready again if it still contains data. To be called
+ * by the consumer each time it is done serving a port returned by
+ * FifoDataportReadySet_collect().
+ *
+ * @param self (required) pointer to the FifoDataportReadySet context
+ * @param id (required) id of the port
+ * @param port (required) pointer to the FifoDataport context
+ *
+ * @retval true if the port still contains data and has been marked
+ */
+static inline bool
+FifoDataportReadySet_rearm(
+    FifoDataportReadySet* self,
+    size_t id,
+    FifoDataport* port)
+{
+    // Pairs with the barrier in FifoDataportReadySet_add(), see there.
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (FifoDataport_LOAD_ACQUIRE(&port->producer.in) == port->consumer.out)
+    {
+        return false;
+    }
+
+    FifoDataportReadySet_mark(self, id);
+    return true;
+}
+
+
+//------------------------------------------------------------------------------
+/**
+ * @brief returns the ids of the ready ports and clears them from the set. To
+ * be called by the consumer.
+ *
+ * @param self (required) pointer to the FifoDataportReadySet context
+ * @param ids (required) array that will be filled with the port ids, in
+ * ascending order
+ * @param maxIds (required) number of elements of ids, ports that don't fit
+ * stay marked for the next call
+ *
+ * @return number of ids returned
+ */
+static inline size_t
+FifoDataportReadySet_collect(
+    FifoDataportReadySet* self,
+    size_t* ids,
+    size_t maxIds)
+{
+    size_t count = 0;
+
+    for (size_t i = 0; (i < FifoDataportReadySet_WORDS) && (count < maxIds);
+         i++)
+    {
+        // Idle words are only read, so they stay shared in the caches of the
+        // producers.
+        if (0 == __atomic_load_n(&self->ready[i], __ATOMIC_RELAXED))
+        {
+            continue;
+        }
+
+        uint64_t bits = __atomic_exchange_n(&self->ready[i], 0,
+                                            __ATOMIC_ACQUIRE);
+        while ((0 != bits) && (count < maxIds))
+        {
+            ids[count++] = (i * 64) + (size_t)__builtin_ctzll(bits);
+            bits &= bits - 1;
+        }
+
+        if (0 != bits)
+        {
+            // Give back what did not fit.
+            __atomic_fetch_or(&self->ready[i], bits, __ATOMIC_RELAXED);
+        }
+    }
+
+    return count;
+}
+
+
+//------------------------------------------------------------------------------
+/**
+ * @brief like FifoDataportReadySet_collect(), but blocks on a notifier until at
+ * least one port is ready. The producers must signal the notifier when a
+ * port has been marked. To be called by the consumer.
+ *
+ * @param self (required) pointer to the FifoDataportReadySet context
+ * @param notifier (required) notifier the producers signal
+ * @param ids (required) array that will be filled with the port ids
+ * @param maxIds (required) number of elements of ids
+ * @param timeoutMs (required) timeout in milliseconds, can be 0 to wait for
+ * ever
+ *
+ * @return number of ids returned, 0 on timeout
+ */
+static inline size_t
+FifoDataportReadySet_wait(
+    FifoDataportReadySet* self,
+    FifoDataportNotifier* notifier,
+    size_t* ids,
+    size_t maxIds,
+    unsigned timeoutMs)
+{
+    size_t count = FifoDataportReadySet_collect(self, ids, maxIds);
+
+    // A bit is always set before the notifier is signalled, so a signal that
+    // arrives between collecting and blocking is not lost.
+    while ((0 == count) && FifoDataportNotifier_wait(notifier, timeoutMs))
+    {
+        count = FifoDataportReadySet_collect(self, ids, maxIds);
+    }
+
+    return count;
+}
@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/**
+ * @brief Multiple producers for a FifoDataport.
+ * The functions here allow several threads of the producer component to add
+ * data to the same FifoDataport without a mutex, while the consumer keeps
+ * using FifoDataport_getContiguous(), FifoDataport_remove() and the other
+ * consumer functions unchanged.
+ *
+ * A producer reserves space by advancing the shared "reserved" index with a
+ * compare-and-swap, then copies its data there in parallel to the other
+ * producers. Publishing happens in the order of the reservations: a producer
+ * waits until all earlier reservations have been committed and then moves
+ * "in" past its own data. So the consumer never sees a gap, but a producer
+ * that is preempted between reserving and committing delays the commits of
+ * the producers that reserved after it.
+ *
+ * @note All producers of a FifoDataport must use the functions here, they
+ * can't be mixed with FifoDataport_add() or FifoDataport_write().
+ *
+ */
+#pragma once
+
+#include "lib_io/FifoDataport.h"
+
+#include <stdint.h>
+
+
+//------------------------------------------------------------------------------
+/**
+ * @brief reserves space for a certain amount of bytes in the FIFO in the
+ * dataport, to be used by one of multiple producers
+ *
+ * @param self (required) pointer to the FifoDataport context
+ * @param len (required) amount of bytes to reserve
+ * @param segments (required) array of two segments that will be set to the
+ * reserved space, the second one is used if the space wraps around
+ * @param pos (required) pointer to a variable that will be set to the position
+ * of the reservation, to be passed to FifoDataport_commitShared()
+ *
+ * @retval true if succeeded, false if there is not enough space
+ */
+static inline bool
+FifoDataport_reserveShared(
+    FifoDataport* self,
+    size_t len,
+    FifoDataport_Segment segments[2],
+    size_t* pos)
+{
+    size_t capacity = FifoDataport_getCapacity(self);
+    size_t reserved = FifoDataport_LOAD_RELAXED(&self->producer.reserved);
+
+    do
+    {
+        // Loading "out" with acquire semantics makes sure the consumer is
+        // done with the space we are about to reserve.
+        size_t out = FifoDataport_LOAD_ACQUIRE(&self->consumer.out);
+        if ((capacity - (reserved - out)) < len)
+        {
+            return false;
+        }
+    }
+    while (!__atomic_compare_exchange_n(&self->producer.reserved,
+                                        &reserved,
+                                        reserved + len,
+                                        true,
+                                        __ATOMIC_RELAXED,
+                                        __ATOMIC_RELAXED));
+
+    FifoDataport_splitSegments(self,
+                               FifoDataport_toIndex(self, reserved),
+                               len,
+                               segments);
+    *pos = reserved;
+    return true;
+}
+
+
+//------------------------------------------------------------------------------
+/**
+ * @brief publishes the data written into space reserved with
+ * FifoDataport_reserveShared(). This waits until all earlier reservations
+ * have been committed.
+ *
+ * @param self (required) pointer to the FifoDataport context
+ * @param pos (required) position set by FifoDataport_reserveShared()
+ * @param len (required) amount of bytes that has been reserved
+ */
+static inline void
+FifoDataport_commitShared(
+    FifoDataport* self,
+    size_t pos,
+    size_t len)
+{
+    // The acquire pairs with the release of the previous committer, so we
+    // also see its update of "last".
+    while (FifoDataport_LOAD_ACQUIRE(&self->producer.in) != pos)
+    {
+        FifoDataport_CPU_RELAX();
+    }
+
+    self->producer.last = FifoDataport_advance(self, self->producer.last, len);
+    FifoDataport_statsAdded(self, len);
+    FifoDataport_latencyStamp(self, pos + len);
+    // Publish the data to the consumer only after it has been written.
+    FifoDataport_STORE_RELEASE(&self->producer.in, pos + len);
+}
+
+
+//------------------------------------------------------------------------------
+/**
+ * @brief copies a block of bytes from a given buffer into the FIFO in the
+ * dataport, to be used by one of multiple producers. Unlike
+ * FifoDataport_write(), either the whole block is copied or nothing, so blocks
+ * of different producers are never interleaved.
+ *
+ * @param self (required) pointer to the FifoDataport context
+ * @param buf (required) pointer to the source buffer
+ * @param len (required) amount of bytes to take from buf
+ *
+ * @return len if the block has been copied, 0 if there is not enough space
+ */
+static inline size_t
+FifoDataport_writeShared(
+    FifoDataport* self,
+    void const* buf,
+    size_t len)
+{
+    char const* source = buf;
+
+    if ((NULL == source) || (0 == len))
+    {
+        return 0;
+    }
+
+    FifoDataport_Segment segments[2];
+    size_t pos;
+    if (!FifoDataport_reserveShared(self, len, segments, &pos))
+    {
+        return 0;
+    }
+
+    FifoDataport_copyIn(self, segments[0].buffer, source, segments[0].len);
+    if (segments[1].len > 0)
+    {
+        FifoDataport_copyIn(self, segments[1].buffer, &source[segments[0].len],
+                            segments[1].len);
+    }
+
+    FifoDataport_commitShared(self, pos, len);
+    return len;
+}
@@ -0,0 +1,397 @@
+/*
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/**
+ * @brief Slab allocator in a dataport.
+ * Objects of variable size are allocated in the dataport by one side and freed
+ * by the other side. They are referred to by handles, which hold the offset of
+ * the block in the data area, so they are valid in all address spaces the
+ * dataport is mapped to. Only the handles are passed through a FifoDataport,
+ * see FifoDataportSlab_send() and FifoDataportSlab_receive(). The dataport is
+ * organised in the following way:
+ *  __________________________________________________________________________
+ * | ----------|-------|--------|-----------|---------------------------------|
+ * || allocator| freer | config | class map |            blocks              ||
+ * | ----------|-------|--------|-----------|---------------------------------|
+ * |__________________________________________________________________________|
+ *
+ * The blocks have sizes in powers of two from FifoDataport_CACHE_LINE_SIZE on,
+ * one size class for each. They are carved from the data area on demand and
+ * never go back to it, but to the free list of their class. A handle is the
+ * offset of its block plus the number of the class, which fits in the low bits
+ * since blocks are aligned to cache lines. The data area starts with a map
+ * that holds one byte for each FifoDataport_CACHE_LINE_SIZE bytes of it. When a
+ * block is carved, its class is stored in the byte of its first cache line, so
+ * a handle from the other side can be checked to refer to a block exactly as
+ * it was carved.
+ *
+ * Each class has two free lists. The freeing side pushes blocks to a shared
+ * stack. The allocator takes blocks from its private list and, when that is
+ * empty, takes the whole shared stack at once with an atomic exchange. So the
+ * allocator needs no compare-and-swap, the stack has no ABA problem since
+ * blocks are never taken from it one by one, and the blocks freed last are
+ * reused first while they may still be in the cache.
+ *
+ * @note The slab is supposed to be created by the allocating side.
+ *
+ */
+#pragma once
+
+#include "lib_io/FifoDataport.h"
+
+#include <stdint.h>
+
+// Number of size classes, the largest block is
+// FifoDataport_CACHE_LINE_SIZE << (FifoDataportSlab_CLASSES - 1). It changes
+// the layout of the dataport, so all components sharing a dataport must use
+// the same setting.
+#if !defined(FifoDataportSlab_CLASSES)
+#define FifoDataportSlab_CLASSES    8
+#endif
+
+// Handle for no block, also marks the end of a free list.
+#define FifoDataportSlab_INVALID    SIZE_MAX
+
+// Entry in the class map for a cache line where no block starts.
+#define FifoDataportSlab_NO_BLOCK   UINT8_MAX
+
+typedef struct
+{
+    // written by the allocator only
+    struct
+    {
+        size_t top;     // offset of the data area not carved into blocks yet
+        size_t free[FifoDataportSlab_CLASSES]; // private free lists
+    }
+    allocator __attribute__((aligned(FifoDataport_CACHE_LINE_SIZE)));
+
+    // pushed by the freeing side, taken by the allocator
+    struct
+    {
+        size_t free[FifoDataportSlab_CLASSES];
+    }
+    freer __attribute__((aligned(FifoDataport_CACHE_LINE_SIZE)));
+
+    // written by the constructor only
+    struct
+    {
+        size_t size;    // size of the data area
+    }
+    config __attribute__((aligned(FifoDataport_CACHE_LINE_SIZE)));
+
+    char data[] __attribute__((aligned(FifoDataport_CACHE_LINE_SIZE)));
+}
+FifoDataportSlab;
+
+// Size of a dataport holding a slab with a data area of the given size, the
+// class map at its start takes 1/FifoDataport_CACHE_LINE_SIZE of it.
+#define FifoDataportSlab_SIZE(_dataSize_) \
+    (sizeof(FifoDataportSlab) + (size_t)(_dataSize_))
+
+
+//------------------------------------------------------------------------------
+// Returns the class map at the start of the data area, it has an entry for
+// each cache line of the data area.
+static inline uint8_t*
+FifoDataportSlab_getClassMap(
+    FifoDataportSlab* self)
+{
+    return (uint8_t*)self->data;
+}
+
+
+//------------------------------------------------------------------------------
+/**
+ * @brief FifoDataportSlab constructor, all of the data area is free afterwards
+ *
+ * @param self (required) pointer to the FifoDataportSlab context
+ * @param size (required) size of the data area in bytes, the dataport must be
+ * at least FifoDataportSlab_SIZE(size) bytes
+ *
+ * @retval true if succeeded
+ */
+static inline bool
+FifoDataportSlab_ctor(
+    FifoDataportSlab* self,
+    size_t size)
+{
+    // The blocks are carved after the class map.
+    size_t lines = size / FifoDataport_CACHE_LINE_SIZE;
+    size_t mapSize = (lines + FifoDataport_CACHE_LINE_SIZE - 1)
+                     & ~((size_t)FifoDataport_CACHE_LINE_SIZE - 1);
+
+    if ((NULL == self) || (size < mapSize + FifoDataport_CACHE_LINE_SIZE))
+    {
+        return false;
+    }
+
+    memset(FifoDataportSlab_getClassMap(self),
+           FifoDataportSlab_NO_BLOCK,
+           lines);
+
+    self->config.size = size;
+    FifoDataport_STORE_RELEASE(&self->allocator.top, mapSize);
+
+    for (size_t i = 0; i < FifoDataportSlab_CLASSES; i++)
+    {
+        self->allocator.free[i] = FifoDataportSlab_INVALID;
+        // Storing the shared lists last with release semantics makes the
+        // whole header visible to the freeing side.
+        FifoDataport_STORE_RELEASE(&self->freer.free[i],
+                                   FifoDataportSlab_INVALID);
+    }
+
+    return true;
+}
+
+
+//------------------------------------------------------------------------------
+/**
+ * @brief returns the size of the block of a handle
+ *
+ * @param handle (required) handle of the block
+ *
+ * @return size of the block in bytes
+ */
+static inline size_t
+FifoDataportSlab_getBlockSize(
+    size_t handle)
+{
+    return (size_t)FifoDataport_CACHE_LINE_SIZE
+           << (handle % FifoDataport_CACHE_LINE_SIZE);
+}
+
+
+//------------------------------------------------------------------------------
+// Returns true if a handle refers to a block that has been carved with this
+// offset and class, so blocks of different handles never overlap. A handle
+// passed through a FifoDataport was carved before it was sent, so the freeing
+// side sees a "top" that covers it. The acquire pairs with the release in
+// FifoDataportSlab_alloc(), which makes the class map up to "top" visible.
+static inline bool
+FifoDataportSlab_isValid(
+    FifoDataportSlab* self,
+    size_t handle)
+{
+    size_t sizeClass = handle % FifoDataport_CACHE_LINE_SIZE;
+    size_t offset = handle - sizeClass;
+    size_t top = FifoDataport_LOAD_ACQUIRE(&self->allocator.top);
+
+    uint8_t const* classMap = FifoDataportSlab_getClassMap(self);
+
+    return (offset < top)
+           && (classMap[offset / FifoDataport_CACHE_LINE_SIZE] == sizeClass);
+}
+
+
+//------------------------------------------------------------------------------
+/**
+ * @brief returns the block of a handle, after checking the handle. Can be
+ * called by both sides.
+ *
+ * @param self (required) pointer to the FifoDataportSlab context
+ * @param handle (required) handle of the block
+ *
+ * @return pointer to the block or NULL if the handle is invalid
+ */
+static inline void*
+FifoDataportSlab_getBuffer(
+    FifoDataportSlab* self,
+    size_t handle)
+{
+    if (!FifoDataportSlab_isValid(self, handle))
+    {
+        Debug_LOG_ERROR("FifoDataportSlab invalid handle %zx", handle);
+        return NULL;
+    }
+
+    return &self->data[handle - (handle % FifoDataport_CACHE_LINE_SIZE)];
+}
+
+
+//------------------------------------------------------------------------------
+// Returns the location in a free block where the handle of the next free
+// block is kept.
+static inline size_t*
+FifoDataportSlab_getNext(
+    FifoDataportSlab* self,
+    size_t handle)
+{
+    return (size_t*)&self->data[handle - (handle % FifoDataport_CACHE_LINE_SIZE)];
+}
+
+
+//------------------------------------------------------------------------------
+/**
+ * @brief allocates a block in the data area. To be called by the allocating
+ * side.
+ *
+ * @param self (required) pointer to the FifoDataportSlab context
+ * @param len (required) minimum size of the block in bytes
+ *
+ * @return handle of the block or FifoDataportSlab_INVALID if there is no
+ * block of this size available
+ */
+static inline size_t
+FifoDataportSlab_alloc(
+    FifoDataportSlab* self,
+    size_t len)
+{
+    size_t sizeClass = 0;
+    while ((sizeClass < FifoDataportSlab_CLASSES)
+           && (((size_t)FifoDataport_CACHE_LINE_SIZE << sizeClass) < len))
+    {
+        sizeClass++;
+    }
+    if (sizeClass >= FifoDataportSlab_CLASSES)
+    {
+        Debug_LOG_ERROR("FifoDataportSlab_alloc() len %zu too large", len);
+        return FifoDataportSlab_INVALID;
+    }
+
+    size_t handle = self->allocator.free[sizeClass];
+    if (FifoDataportSlab_INVALID == handle)
+    {
+        // The shared stack becomes our private list. The acquire pairs with
+        // the release of the freeing side, so the links in the blocks are
+        // visible.
+        handle = __atomic_exchange_n(&self->freer.free[sizeClass],
+                                     FifoDataportSlab_INVALID,
+                                     __ATOMIC_ACQUIRE);
+    }
+
+    // The handles in the free lists come from the freeing side, and so do
+    // the links in the blocks. Each one is checked before it is followed, a
+    // bad one drops the rest of the list.
+    if ((FifoDataportSlab_INVALID != handle)
+        && ((handle % FifoDataport_CACHE_LINE_SIZE != sizeClass)
+            || !FifoDataportSlab_isValid(self, handle)))
+    {
+        Debug_LOG_ERROR("FifoDataportSlab invalid free block %zx", handle);
+        handle = FifoDataportSlab_INVALID;
+    }
+
+    if (FifoDataportSlab_INVALID != handle)
+    {
+        self->allocator.free[sizeClass] = *FifoDataportSlab_getNext(self,
+                                                                    handle);
+        return handle;
+    }
+    self->allocator.free[sizeClass] = FifoDataportSlab_INVALID;
+
+    // Carve a new block, aligned to its size.
+    size_t blockSize = (size_t)FifoDataport_CACHE_LINE_SIZE << sizeClass;
+    size_t offset = (self->allocator.top + blockSize - 1) & ~(blockSize - 1);
+    if ((offset > self->config.size)
+        || (self->config.size - offset < blockSize))
+    {
+        return FifoDataportSlab_INVALID;
+    }
+    // Published for the freeing side's checks, see FifoDataportSlab_isValid().
+    FifoDataportSlab_getClassMap(self)[offset / FifoDataport_CACHE_LINE_SIZE] =
+        (uint8_t)sizeClass;
+    FifoDataport_STORE_RELEASE(&self->allocator.top, offset + blockSize);
+
+    return offset + sizeClass;
+}
+
+
+//------------------------------------------------------------------------------
+/**
+ * @brief frees a block, it must not be used anymore afterwards. To be called
+ * by the freeing side.
+ *
+ * @param self (required) pointer to the FifoDataportSlab context
+ * @param handle (required) handle of the block
+ *
+ * @retval true if succeeded, false if the handle is invalid
+ */
+static inline bool
+FifoDataportSlab_free(
+    FifoDataportSlab* self,
+    size_t handle)
+{
+    if (NULL == FifoDataportSlab_getBuffer(self, handle))
+    {
+        return false;
+    }
+
+    size_t sizeClass = handle % FifoDataport_CACHE_LINE_SIZE;
+    size_t* next = FifoDataportSlab_getNext(self, handle);
+    size_t head = FifoDataport_LOAD_RELAXED(&self->freer.free[sizeClass]);
+
+    // The allocator can only take the whole stack, so "head" is either still
+    // the top of the stack or the stack has been emptied.
+    do
+    {
+        *next = head;
+    }
+    while (!__atomic_compare_exchange_n(&self->freer.free[sizeClass],
+                                        &head,
+                                        handle,
+                                        true,
+                                        __ATOMIC_RELEASE,
+                                        __ATOMIC_RELAXED));
+
+    return true;
+}
+
+
+//------------------------------------------------------------------------------
+/**
+ * @brief passes a handle through a FifoDataport. To be called by the producer
+ * of the port.
+ *
+ * @param port (required) pointer to the FifoDataport context
+ * @param handle (required) handle of the block
+ *
+ * @retval true if succeeded, false if there is not enough space in the port
+ */
+static inline bool
+FifoDataportSlab_send(
+    FifoDataport* port,
+    size_t handle)
+{
+    size_t in = port->producer.in;
+    size_t free = FifoDataport_getCapacity(port)
+                  - (in - FifoDataport_syncOut(port, sizeof(handle)));
+    if (free < sizeof(handle))
+    {
+        return false;
+    }
+
+    FifoDataport_write(port, &handle, sizeof(handle));
+    return true;
+}
+
+
+//------------------------------------------------------------------------------
+/**
+ * @brief takes a handle from a FifoDataport. To be called by the consumer of
+ * the port.
+ *
+ * @param port (required) pointer to the FifoDataport context
+ * @param handle (required) pointer to a variable that will be set to the
+ * handle
+ *
+ * @retval true if succeeded, false if there is no handle in the port
+ */
+static inline bool
+FifoDataportSlab_receive(
+    FifoDataport* port,
+    size_t* handle)
+{
+    if ((FifoDataport_syncIn(port, sizeof(*handle)) - port->consumer.out)
+        < sizeof(*handle))
+    {
+        return false;
+    }
+
+    FifoDataport_read(port, handle, sizeof(*handle));
+    return true;
+}
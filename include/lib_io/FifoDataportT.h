@@ -0,0 +1,292 @@
+/*
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/**
+ * @brief Typed FIFO of fixed-size elements in a dataport.
+ * FifoDataportT_DECLARE(TYPE, NAME, CAPACITY) declares the type NAME for a
+ * FIFO of CAPACITY elements of TYPE and its functions NAME_xxx(). The capacity
+ * is given in elements at compile time and must be a power of two, so a slot
+ * is addressed by masking and elements never wrap around. Producer and
+ * consumer indices are on separate cache lines with a private copy of the
+ * peer's index each, following the same memory model as FifoDataport.h:
+ *  __________________________________________________________________________
+ * | ----------|----------|---------------------------------------------------|
+ * || producer | consumer |              slots[CAPACITY]                     ||
+ * | ----------|----------|---------------------------------------------------|
+ * |__________________________________________________________________________|
+ *
+ * Example for a header shared by both components:
+ *
+ *      typedef struct { uint32_t id; uint32_t value; } Sample;
+ *      FifoDataportT_DECLARE(Sample, SampleFifo, 256)
+ *
+ * Then the producer calls SampleFifo_ctor() on the dataport and both sides use
+ * SampleFifo_push()/SampleFifo_pop(), the batch versions, or
+ * SampleFifo_getFreeSlot()/SampleFifo_add() and
+ * SampleFifo_getFirst()/SampleFifo_remove() for zero-copy access.
+ *
+ * @note The FIFO is supposed to be created by the Producer. TYPE must be a
+ * type name that can be used in a declaration as "TYPE x".
+ *
+ */
+#pragma once
+
+#include "lib_io/FifoDataport.h"
+
+
+#define FifoDataportT_DECLARE(TYPE, NAME, CAPACITY)                            \
+                                                                               \
+_Static_assert(((CAPACITY) > 0) && (0 == ((CAPACITY) & ((CAPACITY) - 1))),    \
+               #NAME " capacity must be a power of two");                      \
+                                                                               \
+typedef struct                                                                 \
+{                                                                              \
+    /* written by the producer only */                                         \
+    struct                                                                     \
+    {                                                                          \
+        size_t in;      /* total amount of elements ever added */              \
+        size_t outSeen; /* last value of "out" loaded by the producer */       \
+    }                                                                          \
+    producer __attribute__((aligned(FifoDataport_CACHE_LINE_SIZE)));           \
+                                                                               \
+    /* written by the consumer only */                                         \
+    struct                                                                     \
+    {                                                                          \
+        size_t out;     /* total amount of elements ever removed */            \
+        size_t inSeen;  /* last value of "in" loaded by the consumer */        \
+    }                                                                          \
+    consumer __attribute__((aligned(FifoDataport_CACHE_LINE_SIZE)));           \
+                                                                               \
+    TYPE slots[CAPACITY] __attribute__((aligned(FifoDataport_CACHE_LINE_SIZE)));\
+}                                                                              \
+NAME;                                                                          \
+                                                                               \
+/* Constructor, to be called by the producer. */                              \
+static inline bool                                                             \
+NAME##_ctor(                                                                   \
+    NAME* self)                                                                \
+{                                                                              \
+    if (NULL == self)                                                          \
+    {                                                                          \
+        return false;                                                          \
+    }                                                                          \
+    self->consumer.out = 0;                                                    \
+    self->consumer.inSeen = 0;                                                 \
+    self->producer.outSeen = 0;                                                \
+    FifoDataport_STORE_RELEASE(&self->producer.in, 0);                         \
+    return true;                                                               \
+}                                                                              \
+                                                                               \
+/* Returns the capacity in elements. */                                       \
+static inline size_t                                                           \
+NAME##_getCapacity(                                                            \
+    NAME* self)                                                                \
+{                                                                              \
+    (void)self;                                                                \
+    return (CAPACITY);                                                         \
+}                                                                              \
+                                                                               \
+/* Returns the amount of elements in the FIFO, can be called by both sides. */\
+static inline size_t                                                           \
+NAME##_getSize(                                                                \
+    NAME* self)                                                                \
+{                                                                              \
+    size_t out = FifoDataport_LOAD_ACQUIRE(&self->consumer.out);               \
+    size_t in = FifoDataport_LOAD_ACQUIRE(&self->producer.in);                 \
+    return in - out;                                                           \
+}                                                                              \
+                                                                               \
+/* Consumer side only. Returns the amount of elements available, the         \
+ * producer's index is read only if our copy does not cover "wanted". */      \
+static inline size_t                                                           \
+NAME##_getUsed(                                                                \
+    NAME* self,                                                                \
+    size_t wanted)                                                             \
+{                                                                              \
+    size_t out = self->consumer.out;                                           \
+    if ((self->consumer.inSeen - out) < wanted)                                \
+    {                                                                          \
+        self->consumer.inSeen =                                                \
+            FifoDataport_LOAD_ACQUIRE(&self->producer.in);                     \
+    }                                                                          \
+    return self->consumer.inSeen - out;                                        \
+}                                                                              \
+                                                                               \
+/* Producer side only. Returns the amount of free slots, the consumer's      \
+ * index is read only if our copy does not cover "wanted". */                 \
+static inline size_t                                                           \
+NAME##_getFree(                                                                \
+    NAME* self,                                                                \
+    size_t wanted)                                                             \
+{                                                                              \
+    size_t in = self->producer.in;                                             \
+    if (((CAPACITY) - (in - self->producer.outSeen)) < wanted)                 \
+    {                                                                          \
+        self->producer.outSeen =                                               \
+            FifoDataport_LOAD_ACQUIRE(&self->consumer.out);                    \
+    }                                                                          \
+    return (CAPACITY) - (in - self->producer.outSeen);                         \
+}                                                                              \
+                                                                               \
+static inline bool                                                             \
+NAME##_isEmpty(                                                                \
+    NAME* self)                                                                \
+{                                                                              \
+    return (0 == NAME##_getSize(self));                                        \
+}                                                                              \
+                                                                               \
+static inline bool                                                             \
+NAME##_isFull(                                                                 \
+    NAME* self)                                                                \
+{                                                                              \
+    return (NAME##_getSize(self) == (CAPACITY));                               \
+}                                                                              \
+                                                                               \
+/* Producer side only. Returns the next free slot to be filled in place and  \
+ * published with NAME_add(), or NULL if the FIFO is full. */                 \
+static inline TYPE*                                                            \
+NAME##_getFreeSlot(                                                            \
+    NAME* self)                                                                \
+{                                                                              \
+    if (0 == NAME##_getFree(self, 1))                                          \
+    {                                                                          \
+        return NULL;                                                           \
+    }                                                                          \
+    return &self->slots[self->producer.in & ((CAPACITY) - 1)];                 \
+}                                                                              \
+                                                                               \
+/* Producer side only. Publishes "amount" filled slots. */                    \
+static inline void                                                             \
+NAME##_add(                                                                    \
+    NAME* self,                                                                \
+    size_t amount)                                                             \
+{                                                                              \
+    size_t free = NAME##_getFree(self, amount);                                \
+    if (amount > free)                                                         \
+    {                                                                          \
+        Debug_LOG_ERROR(#NAME "_add() amount %zu > free %zu",                  \
+                        amount, free);                                         \
+        assert(0);                                                             \
+    }                                                                          \
+    FifoDataport_STORE_RELEASE(&self->producer.in,                             \
+                               self->producer.in + amount);                    \
+}                                                                              \
+                                                                               \
+/* Consumer side only. Returns the first element to be used in place and     \
+ * released with NAME_remove(), or NULL if the FIFO is empty. */              \
+static inline TYPE*                                                            \
+NAME##_getFirst(                                                               \
+    NAME* self)                                                                \
+{                                                                              \
+    if (0 == NAME##_getUsed(self, 1))                                          \
+    {                                                                          \
+        return NULL;                                                           \
+    }                                                                          \
+    return &self->slots[self->consumer.out & ((CAPACITY) - 1)];                \
+}                                                                              \
+                                                                               \
+/* Consumer side only. Releases "amount" elements. */                         \
+static inline void                                                             \
+NAME##_remove(                                                                 \
+    NAME* self,                                                                \
+    size_t amount)                                                             \
+{                                                                              \
+    size_t used = NAME##_getUsed(self, amount);                                \
+    if (amount > used)                                                         \
+    {                                                                          \
+        Debug_LOG_ERROR(#NAME "_remove() amount %zu > used %zu",               \
+                        amount, used);                                         \
+        assert(0);                                                             \
+    }                                                                          \
+    FifoDataport_STORE_RELEASE(&self->consumer.out,                            \
+                               self->consumer.out + amount);                   \
+}                                                                              \
+                                                                               \
+/* Producer side only. Copies up to "n" elements into the FIFO with at most  \
+ * two copies, returns the amount of elements copied. */                      \
+static inline size_t                                                           \
+NAME##_pushBatch(                                                              \
+    NAME* self,                                                                \
+    TYPE const* elems,                                                         \
+    size_t n)                                                                  \
+{                                                                              \
+    size_t space = NAME##_getFree(self, n);                                    \
+    size_t count = (n < space) ? n : space;                                    \
+    size_t index = self->producer.in & ((CAPACITY) - 1);                       \
+    size_t first = (CAPACITY) - index;                                         \
+    if (first > count)                                                         \
+    {                                                                          \
+        first = count;                                                         \
+    }                                                                          \
+    if (count > 0)                                                             \
+    {                                                                          \
+        memcpy(&self->slots[index], elems, first * sizeof(TYPE));              \
+        memcpy(self->slots, &elems[first], (count - first) * sizeof(TYPE));    \
+        FifoDataport_STORE_RELEASE(&self->producer.in,                         \
+                                   self->producer.in + count);                 \
+    }                                                                          \
+    return count;                                                              \
+}                                                                              \
+                                                                               \
+/* Consumer side only. Moves up to "n" elements out of the FIFO with at most \
+ * two copies, returns the amount of elements moved. */                       \
+static inline size_t                                                           \
+NAME##_popBatch(                                                               \
+    NAME* self,                                                                \
+    TYPE* elems,                                                               \
+    size_t n)                                                                  \
+{                                                                              \
+    size_t used = NAME##_getUsed(self, n);                                     \
+    size_t count = (n < used) ? n : used;                                      \
+    size_t index = self->consumer.out & ((CAPACITY) - 1);                      \
+    size_t first = (CAPACITY) - index;                                         \
+    if (first > count)                                                         \
+    {                                                                          \
+        first = count;                                                         \
+    }                                                                          \
+    if (count > 0)                                                             \
+    {                                                                          \
+        memcpy(elems, &self->slots[index], first * sizeof(TYPE));              \
+        memcpy(&elems[first], self->slots, (count - first) * sizeof(TYPE));    \
+        FifoDataport_STORE_RELEASE(&self->consumer.out,                        \
+                                   self->consumer.out + count);                \
+    }                                                                          \
+    return count;                                                              \
+}                                                                              \
+                                                                               \
+/* Producer side only. Copies one element into the FIFO. */                   \
+static inline bool                                                             \
+NAME##_push(                                                                   \
+    NAME* self,                                                                \
+    TYPE const* elem)                                                          \
+{                                                                              \
+    TYPE* slot = NAME##_getFreeSlot(self);                                     \
+    if (NULL == slot)                                                          \
+    {                                                                          \
+        return false;                                                          \
+    }                                                                          \
+    *slot = *elem;                                                             \
+    FifoDataport_STORE_RELEASE(&self->producer.in, self->producer.in + 1);     \
+    return true;                                                               \
+}                                                                              \
+                                                                               \
+/* Consumer side only. Moves one element out of the FIFO. */                  \
+static inline bool                                                             \
+NAME##_pop(                                                                    \
+    NAME* self,                                                                \
+    TYPE* elem)                                                                \
+{                                                                              \
+    TYPE* slot = NAME##_getFirst(self);                                        \
+    if (NULL == slot)                                                          \
+    {                                                                          \
+        return false;                                                          \
+    }                                                                          \
+    *elem = *slot;                                                             \
+    FifoDataport_STORE_RELEASE(&self->consumer.out, self->consumer.out + 1);   \
+    return true;                                                               \
+}
@@ -0,0 +1,272 @@
+/*
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/* Includes ------------------------------------------------------------------*/
+
+#include "lib_io/DataportStream.h"
+
+#include "lib_debug/Debug.h"
+#include <stdbool.h>
+#include <string.h>
+
+
+/* Defines -------------------------------------------------------------------*/
+
+/* Private functions prototypes ----------------------------------------------*/
+
+static size_t
+readPort(DataportStream* self, char* buffer, size_t length);
+
+static void
+removePort(DataportStream* self, size_t amount);
+
+
+/* Private variables ---------------------------------------------------------*/
+
+static const Stream_Vtable DataportStream_vtable =
+{
+    .read       = DataportStream_read,
+    .get        = DataportStream_get,
+    .write      = DataportStream_write,
+    .available  = DataportStream_available,
+    .flush      = DataportStream_flush,
+    .skip       = DataportStream_skip,
+    .close      = DataportStream_flush,
+    .dtor       = DataportStream_dtor
+};
+
+
+/* Public functions ----------------------------------------------------------*/
+
+bool
+DataportStream_ctor(DataportStream* self,
+                    FifoDataport* readPort,
+                    FifoDataport* writePort,
+                    FifoDataportNotifier* notifier,
+                    FifoDataportNotifier* peerNotifier)
+{
+    Debug_ASSERT_SELF(self);
+
+    if ((NULL == readPort) && (NULL == writePort))
+    {
+        Debug_LOG_ERROR("neither read nor write FifoDataport given");
+        return false;
+    }
+    self->readPort  = readPort;
+    self->writePort = writePort;
+    self->notifier  = notifier;
+    self->peerNotifier = peerNotifier;
+    self->parent.vtable = &DataportStream_vtable;
+
+    return true;
+}
+
+size_t
+DataportStream_write(Stream* stream, char const* buffer, size_t length)
+{
+    DataportStream* self = (DataportStream*) stream;
+    Debug_ASSERT_SELF(self);
+    Debug_ASSERT(buffer != NULL);
+
+    if (NULL == self->writePort)
+    {
+        return 0;
+    }
+
+    if (NULL == self->peerNotifier)
+    {
+        return FifoDataport_write(self->writePort, buffer, length);
+    }
+    return FifoDataport_writeAndNotify(self->writePort,
+                                       buffer,
+                                       length,
+                                       self->peerNotifier);
+}
+
+size_t
+DataportStream_read(Stream* stream, char* buffer, size_t length)
+{
+    DataportStream* self = (DataportStream*) stream;
+    Debug_ASSERT_SELF(self);
+    Debug_ASSERT(buffer != NULL);
+
+    if (NULL == self->readPort)
+    {
+        return 0;
+    }
+
+    return readPort(self, buffer, length);
+}
+
+size_t
+DataportStream_get(Stream* stream,
+                   char* buff,
+                   size_t len,
+                   const char* delims,
+                   unsigned timeoutTicks)
+{
+    DataportStream* self = (DataportStream*) stream;
+    Debug_ASSERT_SELF(self);
+    Debug_ASSERT(buff != NULL);
+
+    FifoDataport* port = self->readPort;
+
+    if (0 != timeoutTicks)
+    {
+        Debug_LOG_ERROR("timeouts are not supported");
+        return 0;
+    }
+    if (NULL == port)
+    {
+        return 0;
+    }
+
+    // InputFifoStream_get() uses strchr(), which also matches the terminating
+    // NUL of delims. Here only the characters before it are delimiters, so an
+    // empty string means there are none.
+    size_t numDelims = (NULL != delims) ? strlen(delims) : 0;
+
+    size_t i = 0;
+    while (i < len)
+    {
+        if (FifoDataport_isEmpty(port))
+        {
+            if (NULL == self->notifier)
+            {
+                break;
+            }
+            FifoDataport_waitData(port, self->notifier, 0);
+            continue;
+        }
+
+        // Copy everything up to the delimiter at once. The delimiter itself is
+        // consumed but not stored, like InputFifoStream_get() does. Without a
+        // delimiter, only the bytes searched are copied, the peer may have
+        // added more in the meantime, including a delimiter.
+        size_t todo    = len - i;
+        size_t offset  = todo;
+        bool   isDelim = false;
+
+        if (numDelims > 0)
+        {
+            isDelim = FifoDataport_find(port, delims, numDelims, &offset);
+            if (offset >= todo)
+            {
+                isDelim = false;
+                offset  = todo;
+            }
+        }
+
+        i += readPort(self, &buff[i], offset);
+        if (isDelim)
+        {
+            removePort(self, 1);
+            break;
+        }
+    }
+
+    return i;
+}
+
+size_t
+DataportStream_available(Stream* stream)
+{
+    DataportStream* self = (DataportStream*) stream;
+    Debug_ASSERT_SELF(self);
+
+    return (NULL == self->readPort) ? 0 : FifoDataport_getSize(self->readPort);
+}
+
+void
+DataportStream_flush(Stream* stream)
+{
+    DataportStream* self = (DataportStream*) stream;
+    Debug_ASSERT_SELF(self);
+
+    FifoDataport* port = self->writePort;
+
+    if (NULL == port)
+    {
+        return;
+    }
+
+    // The write FifoDataport is drained once all of its capacity is free.
+    if (NULL != self->notifier)
+    {
+        FifoDataport_waitSpace(port,
+                               self->notifier,
+                               FifoDataport_getCapacity(port),
+                               0);
+        return;
+    }
+
+    while (!FifoDataport_isEmpty(port))
+    {
+        FifoDataport_CPU_RELAX();
+    }
+}
+
+void
+DataportStream_skip(Stream* stream)
+{
+    DataportStream* self = (DataportStream*) stream;
+    Debug_ASSERT_SELF(self);
+
+    FifoDataport* port = self->readPort;
+
+    if (NULL == port)
+    {
+        return;
+    }
+
+    size_t size = FifoDataport_getSize(port);
+    if (size > 0)
+    {
+        removePort(self, size);
+    }
+}
+
+void
+DataportStream_dtor(Stream* stream)
+{
+    DECL_UNUSED_VAR(DataportStream * self) = (DataportStream*) stream;
+    Debug_ASSERT_SELF(self);
+
+    // the FifoDataports and the notifiers are owned by the caller
+}
+
+
+/* Private functions ---------------------------------------------------------*/
+
+// The doorbell functions signal the peer only if it is about to block.
+static size_t
+readPort(DataportStream* self, char* buffer, size_t length)
+{
+    if (NULL == self->peerNotifier)
+    {
+        return FifoDataport_read(self->readPort, buffer, length);
+    }
+    return FifoDataport_readAndNotify(self->readPort,
+                                      buffer,
+                                      length,
+                                      self->peerNotifier);
+}
+
+static void
+removePort(DataportStream* self, size_t amount)
+{
+    if (NULL == self->peerNotifier)
+    {
+        FifoDataport_remove(self->readPort, amount);
+        return;
+    }
+    FifoDataport_removeAndNotify(self->readPort, amount, self->peerNotifier);
+}
+
+
+///@}
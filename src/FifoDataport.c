@@ -0,0 +1,262 @@
+/*
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/* Includes ------------------------------------------------------------------*/
+
+#include "lib_io/FifoDataport.h"
+
+#include "lib_debug/Debug.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+
+/* Defines -------------------------------------------------------------------*/
+
+// Comparing each block against every byte of the set gets slower than a
+// lookup table per byte for larger sets.
+#define FIND_MAX_VECTOR_DELIMS  8
+
+
+/* Private functions ---------------------------------------------------------*/
+
+static size_t
+findScalar(
+    const unsigned char*    buf,
+    size_t                  len,
+    const unsigned char*    delims,
+    size_t                  numDelims)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        for (size_t j = 0; j < numDelims; j++)
+        {
+            if (buf[i] == delims[j])
+            {
+                return i;
+            }
+        }
+    }
+    return len;
+}
+
+static size_t
+findTable(
+    const unsigned char*    buf,
+    size_t                  len,
+    const unsigned char*    delims,
+    size_t                  numDelims)
+{
+    bool isDelim[256] = { false };
+
+    for (size_t j = 0; j < numDelims; j++)
+    {
+        isDelim[delims[j]] = true;
+    }
+
+    for (size_t i = 0; i < len; i++)
+    {
+        if (isDelim[buf[i]])
+        {
+            return i;
+        }
+    }
+    return len;
+}
+
+// Searches whole blocks with the widest instructions available for the target
+// and leaves the remaining bytes to findScalar(). Blocks are loaded unaligned,
+// the data in the FIFO can start anywhere.
+static size_t
+findVector(
+    const unsigned char*    buf,
+    size_t                  len,
+    const unsigned char*    delims,
+    size_t                  numDelims)
+{
+    size_t i = 0;
+
+#if defined(__AVX2__)
+
+    __m256i set32[FIND_MAX_VECTOR_DELIMS];
+    for (size_t j = 0; j < numDelims; j++)
+    {
+        set32[j] = _mm256_set1_epi8((char)delims[j]);
+    }
+
+    for (; (i + 32) <= len; i += 32)
+    {
+        __m256i block = _mm256_loadu_si256((const __m256i*)&buf[i]);
+        __m256i hit = _mm256_cmpeq_epi8(block, set32[0]);
+        for (size_t j = 1; j < numDelims; j++)
+        {
+            hit = _mm256_or_si256(hit, _mm256_cmpeq_epi8(block, set32[j]));
+        }
+
+        unsigned int mask = (unsigned int)_mm256_movemask_epi8(hit);
+        if (0 != mask)
+        {
+            return i + (size_t)__builtin_ctz(mask);
+        }
+    }
+
+#endif
+
+#if defined(__SSE2__)
+
+    __m128i set16[FIND_MAX_VECTOR_DELIMS];
+    for (size_t j = 0; j < numDelims; j++)
+    {
+        set16[j] = _mm_set1_epi8((char)delims[j]);
+    }
+
+    for (; (i + 16) <= len; i += 16)
+    {
+        __m128i block = _mm_loadu_si128((const __m128i*)&buf[i]);
+        __m128i hit = _mm_cmpeq_epi8(block, set16[0]);
+        for (size_t j = 1; j < numDelims; j++)
+        {
+            hit = _mm_or_si128(hit, _mm_cmpeq_epi8(block, set16[j]));
+        }
+
+        unsigned int mask = (unsigned int)_mm_movemask_epi8(hit);
+        if (0 != mask)
+        {
+            return i + (size_t)__builtin_ctz(mask);
+        }
+    }
+
+#elif defined(__ARM_NEON)
+
+    uint8x16_t set16[FIND_MAX_VECTOR_DELIMS];
+    for (size_t j = 0; j < numDelims; j++)
+    {
+        set16[j] = vdupq_n_u8(delims[j]);
+    }
+
+    for (; (i + 16) <= len; i += 16)
+    {
+        uint8x16_t block = vld1q_u8(&buf[i]);
+        uint8x16_t hit = vceqq_u8(block, set16[0]);
+        for (size_t j = 1; j < numDelims; j++)
+        {
+            hit = vorrq_u8(hit, vceqq_u8(block, set16[j]));
+        }
+
+#if defined(__aarch64__)
+        bool found = (0 != vmaxvq_u8(hit));
+#else
+        uint8x8_t half = vorr_u8(vget_low_u8(hit), vget_high_u8(hit));
+        bool found = (0 != vget_lane_u64(vreinterpret_u64_u8(half), 0));
+#endif
+        // There is no cheap movemask on NEON, the position in a block with a
+        // hit is taken from the scalar search.
+        if (found)
+        {
+            return i + findScalar(&buf[i], 16, delims, numDelims);
+        }
+    }
+
+#else
+
+    // Word at a time: a byte of (word ^ pattern) is zero where the word
+    // contains the delimiter, which the classic "has zero byte" check detects.
+    // It may flag bytes after a real hit, so the position in a word with a hit
+    // is taken from the scalar search.
+    const size_t ones = SIZE_MAX / 0xFF;
+    const size_t highs = ones * 0x80;
+
+    size_t patterns[FIND_MAX_VECTOR_DELIMS];
+    for (size_t j = 0; j < numDelims; j++)
+    {
+        patterns[j] = ones * delims[j];
+    }
+
+    for (; (i + sizeof(size_t)) <= len; i += sizeof(size_t))
+    {
+        size_t word;
+        memcpy(&word, &buf[i], sizeof(word));
+
+        size_t hit = 0;
+        for (size_t j = 0; j < numDelims; j++)
+        {
+            size_t x = word ^ patterns[j];
+            hit |= (x - ones) & ~x & highs;
+        }
+
+        if (0 != hit)
+        {
+            return i + findScalar(&buf[i], sizeof(size_t), delims, numDelims);
+        }
+    }
+
+#endif
+
+    return i + findScalar(&buf[i], len - i, delims, numDelims);
+}
+
+
+/* Public functions ----------------------------------------------------------*/
+
+bool
+FifoDataport_find(
+    FifoDataport*   self,
+    const void*     delims,
+    size_t          numDelims,
+    size_t*         offset)
+{
+    Debug_ASSERT_SELF(self);
+    Debug_ASSERT(delims != NULL);
+
+    size_t pos = 0;
+    if (0 == numDelims)
+    {
+        if (offset)
+        {
+            *offset = pos;
+        }
+        return false;
+    }
+
+    // FifoDataport_getSegments() always reloads "in", so a caller polling for
+    // a delimiter sees data that arrives after an unsuccessful search.
+    FifoDataport_Segment segments[2];
+    FifoDataport_getSegments(self, segments);
+
+    for (size_t i = 0; (i < 2) && (segments[i].len > 0); i++)
+    {
+        const unsigned char* buf = segments[i].buffer;
+        size_t len = segments[i].len;
+        size_t found = (numDelims > FIND_MAX_VECTOR_DELIMS)
+                       ? findTable(buf, len, (const unsigned char*)delims,
+                                   numDelims)
+                       : findVector(buf, len, (const unsigned char*)delims,
+                                    numDelims);
+        if (found < len)
+        {
+            if (offset)
+            {
+                *offset = pos + found;
+            }
+            return true;
+        }
+        pos += len;
+    }
+
+    if (offset)
+    {
+        *offset = pos;
+    }
+    return false;
+}
@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/* Includes ------------------------------------------------------------------*/
+
+#include "lib_io/FifoDataportEventNotifier.h"
+
+#include "lib_debug/Debug.h"
+#include <stdbool.h>
+
+
+/* Defines -------------------------------------------------------------------*/
+
+/* Private functions prototypes ----------------------------------------------*/
+
+/* Private variables ---------------------------------------------------------*/
+
+static const FifoDataportNotifier_Vtable FifoDataportEventNotifier_vtable =
+{
+    .wait   = FifoDataportEventNotifier_wait,
+    .signal = FifoDataportEventNotifier_signal,
+    .dtor   = FifoDataportEventNotifier_dtor
+};
+
+
+/* Public functions ----------------------------------------------------------*/
+
+bool
+FifoDataportEventNotifier_ctor(FifoDataportEventNotifier* self,
+                               FifoDataportEventNotifier_EventT wait,
+                               FifoDataportEventNotifier_EventT emit)
+{
+    Debug_ASSERT_SELF(self);
+
+    if ((NULL == wait) && (NULL == emit))
+    {
+        Debug_LOG_ERROR("neither wait nor emit function given");
+        return false;
+    }
+    self->wait = wait;
+    self->emit = emit;
+    FifoDataportNotifier_init(&self->parent,
+                              &FifoDataportEventNotifier_vtable);
+    return true;
+}
+
+bool
+FifoDataportEventNotifier_wait(FifoDataportNotifier* notifier,
+                               unsigned timeoutMs)
+{
+    FifoDataportEventNotifier* self = (FifoDataportEventNotifier*) notifier;
+    Debug_ASSERT_SELF(self);
+    Debug_ASSERT(self->wait != NULL);
+
+    if (0 != timeoutMs)
+    {
+        Debug_LOG_ERROR("timeouts are not supported");
+        return false;
+    }
+    self->wait();
+    return true;
+}
+
+void
+FifoDataportEventNotifier_signal(FifoDataportNotifier* notifier)
+{
+    FifoDataportEventNotifier* self = (FifoDataportEventNotifier*) notifier;
+    Debug_ASSERT_SELF(self);
+    Debug_ASSERT(self->emit != NULL);
+
+    self->emit();
+}
+
+void
+FifoDataportEventNotifier_dtor(FifoDataportNotifier* notifier)
+{
+    DECL_UNUSED_VAR(FifoDataportEventNotifier * self) =
+        (FifoDataportEventNotifier*) notifier;
+    Debug_ASSERT_SELF(self);
+}
+
+
+/* Private functions ---------------------------------------------------------*/
+
+
+///@}
@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/* Includes ------------------------------------------------------------------*/
+
+#include "lib_io/FifoDataportEventfdNotifier.h"
+
+#include "lib_debug/Debug.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+
+/* Defines -------------------------------------------------------------------*/
+
+/* Private functions prototypes ----------------------------------------------*/
+
+/* Private variables ---------------------------------------------------------*/
+
+static const FifoDataportNotifier_Vtable FifoDataportEventfdNotifier_vtable =
+{
+    .wait   = FifoDataportEventfdNotifier_wait,
+    .signal = FifoDataportEventfdNotifier_signal,
+    .dtor   = FifoDataportEventfdNotifier_dtor
+};
+
+
+/* Public functions ----------------------------------------------------------*/
+
+bool
+FifoDataportEventfdNotifier_ctor(FifoDataportEventfdNotifier* self)
+{
+    Debug_ASSERT_SELF(self);
+
+    self->fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (self->fd < 0)
+    {
+        Debug_LOG_ERROR("eventfd() failed");
+        return false;
+    }
+    FifoDataportNotifier_init(&self->parent,
+                              &FifoDataportEventfdNotifier_vtable);
+    return true;
+}
+
+bool
+FifoDataportEventfdNotifier_ctorFromFd(FifoDataportEventfdNotifier* self,
+                                       int fd)
+{
+    Debug_ASSERT_SELF(self);
+
+    self->fd = dup(fd);
+    if (self->fd < 0)
+    {
+        Debug_LOG_ERROR("dup() of fd %d failed", fd);
+        return false;
+    }
+    FifoDataportNotifier_init(&self->parent,
+                              &FifoDataportEventfdNotifier_vtable);
+    return true;
+}
+
+int
+FifoDataportEventfdNotifier_getFd(FifoDataportEventfdNotifier* self)
+{
+    Debug_ASSERT_SELF(self);
+    return self->fd;
+}
+
+bool
+FifoDataportEventfdNotifier_wait(FifoDataportNotifier* notifier,
+                                 unsigned timeoutMs)
+{
+    FifoDataportEventfdNotifier* self = (FifoDataportEventfdNotifier*) notifier;
+    Debug_ASSERT_SELF(self);
+
+    struct pollfd pfd = { .fd = self->fd, .events = POLLIN };
+    int timeout = (0 == timeoutMs) ? -1
+                  : (timeoutMs > INT_MAX) ? INT_MAX : (int) timeoutMs;
+
+    int ret;
+    do
+    {
+        ret = poll(&pfd, 1, timeout);
+    }
+    while ((ret < 0) && (EINTR == errno));
+
+    if (ret <= 0)
+    {
+        return false;
+    }
+
+    // Consume all pending signals, the fd is non-blocking so this can't hang
+    // if there is nothing to read anymore.
+    uint64_t count;
+    DECL_UNUSED_VAR(ssize_t n) = read(self->fd, &count, sizeof(count));
+    return true;
+}
+
+void
+FifoDataportEventfdNotifier_signal(FifoDataportNotifier* notifier)
+{
+    FifoDataportEventfdNotifier* self = (FifoDataportEventfdNotifier*) notifier;
+    Debug_ASSERT_SELF(self);
+
+    // This fails only if the counter would overflow, the other side will be
+    // woken up anyway then.
+    uint64_t one = 1;
+    DECL_UNUSED_VAR(ssize_t n) = write(self->fd, &one, sizeof(one));
+}
+
+void
+FifoDataportEventfdNotifier_dtor(FifoDataportNotifier* notifier)
+{
+    FifoDataportEventfdNotifier* self = (FifoDataportEventfdNotifier*) notifier;
+    Debug_ASSERT_SELF(self);
+
+    close(self->fd);
+}
+
+
+/* Private functions ---------------------------------------------------------*/
+
+
+///@}
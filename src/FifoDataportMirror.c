@@ -0,0 +1,190 @@
+/*
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/* Includes ------------------------------------------------------------------*/
+
+#if !defined(_GNU_SOURCE)
+#define _GNU_SOURCE // memfd_create()
+#endif
+
+#include "lib_io/FifoDataportMirror.h"
+
+#include "lib_debug/Debug.h"
+
+#include <stdbool.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+/* Defines -------------------------------------------------------------------*/
+
+// The FifoDataport header is placed at the end of the first page, so the data
+// area starts at the second page.
+#define HEADER_OFFSET(_page_) ((_page_) - offsetof(FifoDataport, data))
+
+
+/* Private functions prototypes ----------------------------------------------*/
+
+static bool
+mapMirrored(FifoDataportMirror* self, size_t page, size_t capacity);
+
+
+/* Public functions ----------------------------------------------------------*/
+
+bool
+FifoDataportMirror_ctor(FifoDataportMirror* self, size_t capacity)
+{
+    Debug_ASSERT_SELF(self);
+
+    size_t page = (size_t) sysconf(_SC_PAGESIZE);
+    Debug_ASSERT(offsetof(FifoDataport, data) <= page);
+
+    if (0 == capacity)
+    {
+        Debug_LOG_ERROR("capacity must not be 0");
+        return false;
+    }
+    capacity = (capacity + page - 1) / page * page;
+
+    self->fd = memfd_create("FifoDataportMirror", MFD_CLOEXEC);
+    if (self->fd < 0)
+    {
+        Debug_LOG_ERROR("memfd_create() failed");
+        goto error1;
+    }
+    if (ftruncate(self->fd, (off_t) (page + capacity)) != 0)
+    {
+        Debug_LOG_ERROR("ftruncate() to %zu failed", page + capacity);
+        goto error2;
+    }
+    if (!mapMirrored(self, page, capacity))
+    {
+        goto error2;
+    }
+    if (!FifoDataport_ctorMirrored(self->port, capacity))
+    {
+        goto error3;
+    }
+    return true;
+
+error3:
+    munmap(self->mapping, self->mappingSize);
+error2:
+    close(self->fd);
+error1:
+    return false;
+}
+
+bool
+FifoDataportMirror_ctorFromFd(FifoDataportMirror* self, int fd)
+{
+    Debug_ASSERT_SELF(self);
+
+    size_t page = (size_t) sysconf(_SC_PAGESIZE);
+    struct stat st;
+
+    if ((fstat(fd, &st) != 0)
+        || (st.st_size <= (off_t) page)
+        || ((size_t) st.st_size % page != 0))
+    {
+        Debug_LOG_ERROR("fd %d is not a FifoDataportMirror memfd", fd);
+        return false;
+    }
+
+    self->fd = dup(fd);
+    if (self->fd < 0)
+    {
+        Debug_LOG_ERROR("dup() of fd %d failed", fd);
+        goto error1;
+    }
+    if (!mapMirrored(self, page, (size_t) st.st_size - page))
+    {
+        goto error2;
+    }
+    if (!self->port->config.mirrored)
+    {
+        Debug_LOG_ERROR("FifoDataport in fd %d is not mirrored", fd);
+        goto error3;
+    }
+    // The header comes from the peer, it must not make us access memory
+    // beyond our mapping.
+    if (self->port->config.capacity != (size_t) st.st_size - page)
+    {
+        Debug_LOG_ERROR("FifoDataport in fd %d has capacity %zu, expected %zu",
+                        fd, self->port->config.capacity,
+                        (size_t) st.st_size - page);
+        goto error3;
+    }
+    return true;
+
+error3:
+    munmap(self->mapping, self->mappingSize);
+error2:
+    close(self->fd);
+error1:
+    return false;
+}
+
+int
+FifoDataportMirror_getFd(FifoDataportMirror* self)
+{
+    Debug_ASSERT_SELF(self);
+    return self->fd;
+}
+
+FifoDataport*
+FifoDataportMirror_getFifoDataport(FifoDataportMirror* self)
+{
+    Debug_ASSERT_SELF(self);
+    return self->port;
+}
+
+void
+FifoDataportMirror_dtor(FifoDataportMirror* self)
+{
+    Debug_ASSERT_SELF(self);
+
+    munmap(self->mapping, self->mappingSize);
+    close(self->fd);
+}
+
+
+/* Private functions ---------------------------------------------------------*/
+
+static bool
+mapMirrored(FifoDataportMirror* self, size_t page, size_t capacity)
+{
+    // Reserve the address range for header, data and mirror first, so the two
+    // mappings of the data area are guaranteed to be back-to-back.
+    self->mappingSize = page + 2 * capacity;
+    self->mapping = mmap(NULL, self->mappingSize, PROT_NONE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (MAP_FAILED == self->mapping)
+    {
+        Debug_LOG_ERROR("mmap() reserving %zu bytes failed", self->mappingSize);
+        return false;
+    }
+
+    char* base = self->mapping;
+    if ((mmap(base, page + capacity, PROT_READ | PROT_WRITE,
+              MAP_SHARED | MAP_FIXED, self->fd, 0) == MAP_FAILED)
+        || (mmap(&base[page + capacity], capacity, PROT_READ | PROT_WRITE,
+                 MAP_SHARED | MAP_FIXED, self->fd, (off_t) page) == MAP_FAILED))
+    {
+        Debug_LOG_ERROR("mmap() of the mirrored data area failed");
+        munmap(self->mapping, self->mappingSize);
+        return false;
+    }
+
+    self->port = (FifoDataport*) &base[HEADER_OFFSET(page)];
+    return true;
+}
+
+
+///@}
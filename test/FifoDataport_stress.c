@@ -0,0 +1,443 @@
+/*
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/*
+ * Host-side stress test of the lock-free FifoDataport variants. Each test runs
+ * the sides of a dataport in separate threads and checks everything that
+ * arrives. It is not part of the library, see LIB_IO_BUILD_TESTS in
+ * CMakeLists.txt. The threads yield whenever they have to wait, so the test
+ * also makes progress on a single core.
+ */
+
+#include "lib_io/FifoDataportBroadcast.h"
+#include "lib_io/FifoDataportLossy.h"
+#include "lib_io/FifoDataportShared.h"
+#include "lib_io/FifoDataportSlab.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define CHECK(_cond_) \
+    do \
+    { \
+        if (!(_cond_)) \
+        { \
+            printf("%s:%d check failed: %s\n", __FILE__, __LINE__, #_cond_); \
+            exit(EXIT_FAILURE); \
+        } \
+    } while (0)
+
+#define SHARED_PRODUCERS    4
+#define SHARED_RECORDS      100000
+#define BROADCAST_RECORDS   200000
+#define LOSSY_RECORDS       500000
+#define SLAB_BLOCKS         200000
+
+
+//------------------------------------------------------------------------------
+// Allocates a dataport of "size" bytes aligned to cache lines.
+static void*
+allocDataport(
+    size_t size)
+{
+    size = (size + FifoDataport_CACHE_LINE_SIZE - 1)
+           & ~((size_t)FifoDataport_CACHE_LINE_SIZE - 1);
+    void* dataport = aligned_alloc(FifoDataport_CACHE_LINE_SIZE, size);
+    CHECK(NULL != dataport);
+    return dataport;
+}
+
+
+//------------------------------------------------------------------------------
+// Multiple producers: every record arrives exactly once, in the order of its
+// producer and never interleaved with another one.
+
+typedef struct
+{
+    uint32_t producer;
+    uint32_t seq;
+    uint32_t check;
+}
+SharedRecord;
+
+static FifoDataport* sharedPort;
+
+static void*
+sharedProducer(
+    void* arg)
+{
+    uint32_t id = (uint32_t)(uintptr_t)arg;
+
+    for (uint32_t seq = 0; seq < SHARED_RECORDS; )
+    {
+        SharedRecord rec = { id, seq, id * 1000003u + seq };
+        if (sizeof(rec) == FifoDataport_writeShared(sharedPort, &rec,
+                                                    sizeof(rec)))
+        {
+            seq++;
+        }
+        // A producer that waits for an earlier commit spins, so on a single
+        // core the producers would otherwise take turns spinning through
+        // their time slices while the one they wait for is preempted.
+        sched_yield();
+    }
+    return NULL;
+}
+
+static void
+testShared(void)
+{
+    // The capacity is no multiple of the record size, so records wrap at all
+    // possible places.
+    size_t capacity = 1000;
+    sharedPort = allocDataport(sizeof(FifoDataport) + capacity);
+    CHECK(FifoDataport_ctor(sharedPort, capacity));
+
+    pthread_t threads[SHARED_PRODUCERS];
+    for (uintptr_t i = 0; i < SHARED_PRODUCERS; i++)
+    {
+        CHECK(0 == pthread_create(&threads[i], NULL, sharedProducer,
+                                  (void*)i));
+    }
+
+    uint32_t next[SHARED_PRODUCERS] = { 0 };
+    for (size_t received = 0; received < SHARED_PRODUCERS * SHARED_RECORDS; )
+    {
+        SharedRecord rec;
+        if (FifoDataport_getSize(sharedPort) < sizeof(rec))
+        {
+            sched_yield();
+            continue;
+        }
+        CHECK(sizeof(rec) == FifoDataport_read(sharedPort, &rec, sizeof(rec)));
+        CHECK(rec.producer < SHARED_PRODUCERS);
+        CHECK(rec.seq == next[rec.producer]);
+        CHECK(rec.check == rec.producer * 1000003u + rec.seq);
+        next[rec.producer]++;
+        received++;
+    }
+
+    for (size_t i = 0; i < SHARED_PRODUCERS; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+    CHECK(FifoDataport_isEmpty(sharedPort));
+    free(sharedPort);
+}
+
+
+//------------------------------------------------------------------------------
+// Broadcast with eviction: a slow consumer is evicted by the producer and
+// joins again. Within each membership it sees a gapless part of the stream,
+// a read that raced with its eviction must not return overwritten data.
+
+static FifoDataportBroadcast* broadcast;
+static bool broadcastDone;
+
+static void*
+broadcastConsumer(
+    void* arg)
+{
+    size_t id = (size_t)arg;
+    bool isSlow = (1 == id);
+    uint64_t last = 0;
+    uint64_t expected = 0;
+    size_t evictions = 0;
+
+    FifoDataportBroadcast_join(broadcast, id);
+
+    for (;;)
+    {
+        uint64_t seq;
+        size_t read = FifoDataportBroadcast_read(broadcast, id, &seq,
+                                                 sizeof(seq));
+        if (sizeof(seq) == read)
+        {
+            // After joining, the stream starts anywhere after what we saw.
+            CHECK((0 == expected) ? (seq > last) : (seq == expected));
+            last = seq;
+            expected = seq + 1;
+            if (isSlow)
+            {
+                struct timespec pause = { 0, 20000 };
+                nanosleep(&pause, NULL);
+            }
+            continue;
+        }
+        CHECK(0 == read);
+
+        FifoDataportBroadcast_State state =
+            FifoDataportBroadcast_getState(broadcast, id);
+        if (FifoDataportBroadcast_State_EVICTED == state)
+        {
+            evictions++;
+            expected = 0;
+            FifoDataportBroadcast_join(broadcast, id);
+        }
+        else if (__atomic_load_n(&broadcastDone, __ATOMIC_ACQUIRE))
+        {
+            // The producer is done, so we are either empty or never become
+            // active again.
+            if ((FifoDataportBroadcast_State_ACTIVE != state)
+                || (0 == FifoDataportBroadcast_read(broadcast, id, &seq,
+                                                    sizeof(seq))))
+            {
+                break;
+            }
+            CHECK((0 == expected) ? (seq > last) : (seq == expected));
+            last = seq;
+            expected = seq + 1;
+        }
+        else
+        {
+            sched_yield();
+        }
+    }
+
+    return (void*)evictions;
+}
+
+static void
+testBroadcast(void)
+{
+    size_t capacity = 4096;
+    broadcast = allocDataport(sizeof(FifoDataportBroadcast) + capacity);
+    CHECK(FifoDataportBroadcast_ctor(broadcast, capacity, 2, true));
+    broadcastDone = false;
+
+    pthread_t threads[2];
+    for (uintptr_t i = 0; i < 2; i++)
+    {
+        CHECK(0 == pthread_create(&threads[i], NULL, broadcastConsumer,
+                                  (void*)i));
+    }
+    for (size_t i = 0; i < 2; i++)
+    {
+        while (FifoDataportBroadcast_State_JOINING
+               != FifoDataportBroadcast_getState(broadcast, i))
+        {
+            sched_yield();
+        }
+    }
+
+    // The producer gives the consumers a chance to catch up before it evicts
+    // the ones in the way, so mostly the slow one gets evicted.
+    for (uint64_t seq = 1; seq <= BROADCAST_RECORDS; )
+    {
+        size_t space = FifoDataportBroadcast_getFree(broadcast);
+        for (size_t i = 0; (i < 16) && (space < sizeof(seq)); i++)
+        {
+            sched_yield();
+            space = FifoDataportBroadcast_getFree(broadcast);
+        }
+        if (sizeof(seq) == FifoDataportBroadcast_write(broadcast, &seq,
+                                                       sizeof(seq)))
+        {
+            seq++;
+        }
+    }
+    __atomic_store_n(&broadcastDone, true, __ATOMIC_RELEASE);
+
+    // The slow consumer can't keep up with a producer that never waits long.
+    void* evictions[2];
+    for (size_t i = 0; i < 2; i++)
+    {
+        pthread_join(threads[i], &evictions[i]);
+    }
+    CHECK(NULL != evictions[1]);
+    free(broadcast);
+}
+
+
+//------------------------------------------------------------------------------
+// Lossy mode: the producer overwrites the oldest records while the consumer
+// reads them. Every record is either read whole and in order or counted as
+// lost, never both.
+
+static FifoDataport* lossyPort;
+static bool lossyDone;
+
+static void*
+lossyProducer(
+    void* arg)
+{
+    (void)arg;
+
+    for (uint64_t seq = 1; seq <= LOSSY_RECORDS; seq++)
+    {
+        FifoDataport_writeLossy(lossyPort, &seq, sizeof(seq));
+        if (0 == (seq % 64))
+        {
+            sched_yield();
+        }
+    }
+    __atomic_store_n(&lossyDone, true, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+static void
+testLossy(void)
+{
+    size_t capacity = 256;
+    lossyPort = allocDataport(sizeof(FifoDataport) + capacity);
+    CHECK(FifoDataport_ctor(lossyPort, capacity));
+    lossyDone = false;
+
+    pthread_t thread;
+    CHECK(0 == pthread_create(&thread, NULL, lossyProducer, NULL));
+
+    uint64_t last = 0;
+    size_t received = 0;
+    size_t lostBytes = 0;
+    for (;;)
+    {
+        bool isDone = __atomic_load_n(&lossyDone, __ATOMIC_ACQUIRE);
+        uint64_t seq;
+        size_t lost;
+        size_t read = FifoDataport_readLossy(lossyPort, &seq, sizeof(seq),
+                                             &lost);
+        lostBytes += lost;
+        if (sizeof(seq) == read)
+        {
+            CHECK(seq > last);
+            last = seq;
+            received++;
+            continue;
+        }
+        CHECK(0 == read);
+        if (isDone)
+        {
+            break;
+        }
+        sched_yield();
+    }
+    pthread_join(thread, NULL);
+
+    CHECK(0 == (lostBytes % sizeof(uint64_t)));
+    CHECK(LOSSY_RECORDS == received + (lostBytes / sizeof(uint64_t)));
+    free(lossyPort);
+}
+
+
+//------------------------------------------------------------------------------
+// Slab: blocks of all classes go to the freeing side and back through the
+// free lists. A block that is handed out twice or overlaps another one shows
+// up as a corrupted pattern.
+
+static FifoDataportSlab* slab;
+static FifoDataport* slabPort;
+
+static size_t
+getSlabBlockLen(
+    uint32_t seq)
+{
+    return sizeof(seq) + ((seq * 37u) % 3000);
+}
+
+static void*
+slabFreer(
+    void* arg)
+{
+    (void)arg;
+
+    for (uint32_t expected = 0; expected < SLAB_BLOCKS; )
+    {
+        size_t handle;
+        if (!FifoDataportSlab_receive(slabPort, &handle))
+        {
+            sched_yield();
+            continue;
+        }
+
+        unsigned char* block = FifoDataportSlab_getBuffer(slab, handle);
+        CHECK(NULL != block);
+        uint32_t seq;
+        memcpy(&seq, block, sizeof(seq));
+        CHECK(seq == expected);
+        size_t len = getSlabBlockLen(seq);
+        CHECK(FifoDataportSlab_getBlockSize(handle) >= len);
+        for (size_t i = sizeof(seq); i < len; i++)
+        {
+            CHECK(block[i] == (unsigned char)seq);
+        }
+
+        CHECK(FifoDataportSlab_free(slab, handle));
+        expected++;
+    }
+    return NULL;
+}
+
+static void
+testSlab(void)
+{
+    size_t size = 1 << 20;
+    slab = allocDataport(FifoDataportSlab_SIZE(size));
+    CHECK(FifoDataportSlab_ctor(slab, size));
+    slabPort = allocDataport(sizeof(FifoDataport) + 64);
+    CHECK(FifoDataport_ctor(slabPort, 64));
+
+    pthread_t thread;
+    CHECK(0 == pthread_create(&thread, NULL, slabFreer, NULL));
+
+    for (uint32_t seq = 0; seq < SLAB_BLOCKS; )
+    {
+        size_t len = getSlabBlockLen(seq);
+        size_t handle = FifoDataportSlab_alloc(slab, len);
+        if (FifoDataportSlab_INVALID == handle)
+        {
+            sched_yield();
+            continue;
+        }
+
+        unsigned char* block = FifoDataportSlab_getBuffer(slab, handle);
+        CHECK(NULL != block);
+        memcpy(block, &seq, sizeof(seq));
+        memset(&block[sizeof(seq)], (unsigned char)seq, len - sizeof(seq));
+
+        while (!FifoDataportSlab_send(slabPort, handle))
+        {
+            sched_yield();
+        }
+        seq++;
+    }
+    pthread_join(thread, NULL);
+
+    free(slabPort);
+    free(slab);
+}
+
+
+//------------------------------------------------------------------------------
+int
+main(void)
+{
+    static const struct
+    {
+        char const* name;
+        void (*run)(void);
+    }
+    tests[] =
+    {
+        { "shared",     testShared },
+        { "broadcast",  testBroadcast },
+        { "lossy",      testLossy },
+        { "slab",       testSlab },
+    };
+
+    for (size_t i = 0; i < sizeof(tests) / sizeof(tests[0]); i++)
+    {
+        tests[i].run();
+        printf("%s: ok\n", tests[i].name);
+    }
+
+    return EXIT_SUCCESS;
+}